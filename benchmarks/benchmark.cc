@@ -0,0 +1,73 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+std::atomic<std::size_t> bytes{0};
+
+}
+
+// Global replacements so every benchmark can count heap allocations
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace patterns::benchmarks {
+
+std::vector<int> threadCounts() {
+    const int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> counts;
+    for (int n = 1; n < cores; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(cores);
+    return counts;
+}
+
+std::size_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+std::size_t allocatedBytes() {
+    return bytes.load(std::memory_order_relaxed);
+}
+
+std::string uniqueTempPath(const std::string& prefix) {
+    std::string path = (std::filesystem::temp_directory_path() / (prefix + ".XXXXXX")).string();
+    const int fd = ::mkstemp(path.data());
+    if (fd < 0) {
+        throw std::runtime_error("cannot create a temporary file for " + prefix);
+    }
+    ::close(fd);
+    return path;
+}
+
+void report(const std::string& name, std::size_t ops, double ms) {
+    const double opsPerSec = (ms > 0.0) ? (ops * 1000.0 / ms) : 0.0;
+    std::printf("%-56s %12zu ops %10.2f ms %14.0f ops/s\n", name.c_str(), ops, ms, opsPerSec);
+}
+
+}
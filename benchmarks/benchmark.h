@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace patterns::benchmarks {
+
+// Wall clock duration of a single call in milliseconds
+template <typename Func>
+double measureMs(Func&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Runs func(threadIndex) on the given number of threads and returns
+// the wall clock duration of the whole run in milliseconds
+template <typename Func>
+double measureThreadsMs(int threads, Func&& func) {
+    return measureMs([threads, &func]() {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back(func, i);
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+    });
+}
+
+// Thread counts from 1 up to the number of cores, doubling each step
+std::vector<int> threadCounts();
+
+// Keeps the optimizer from discarding a computed value
+template <typename T>
+void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+void report(const std::string& name, std::size_t ops, double ms);
+
+// Number of global operator new calls made so far by the process
+std::size_t allocationCount();
+// Bytes requested from global operator new so far by the process
+std::size_t allocatedBytes();
+
+// Creates an empty file of its own in the temporary directory, so parallel
+// runs never share one
+std::string uniqueTempPath(const std::string& prefix);
+
+// Benchmark suites
+void sharedPtrPolicyBenchmark();
+void makeSharedBenchmark();
+void intrusivePtrBenchmark();
+void atomicSharedPtrBenchmark();
+void singletonBenchmark();
+void shapeRegistryBenchmark();
+void shapeVariantBenchmark();
+void objectPoolBenchmark();
+void prototypeBatchBenchmark();
+void prototypeCowBenchmark();
+void prototypeRepresentationBenchmark();
+void prototypeSnapshotBenchmark();
+void dinnerMenuBenchmark();
+void dinnerBatchBenchmark();
+void menuExportBenchmark();
+void cachingProxyBenchmark();
+void allowlistBenchmark();
+void coalescingProxyBenchmark();
+void rateLimitingProxyBenchmark();
+void lazyProxyBenchmark();
+void asyncRequestBenchmark();
+
+}
@@ -0,0 +1,586 @@
+#include "benchmark.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../concurrency/thread_pool.h"
+#include "../creational/builder/builder.h"
+#include "../creational/builder/menu_exporter.h"
+#include "../creational/factorymethod/shape_registry.h"
+#include "../creational/factorymethod/shape_variant.h"
+#include "../creational/objectpool/object_pool.h"
+#include "../creational/prototype/prototype.h"
+#include "../creational/prototype/prototype_snapshot.h"
+#include "../creational/singleton/singleton.h"
+
+namespace patterns::benchmarks {
+
+namespace {
+
+namespace pc = patterns::creational;
+
+constexpr int getsPerThread = 10000000;
+
+class Config final {
+private:
+    friend class pc::Singleton<Config>;
+    Config() = default;
+public:
+    long value = 1;
+};
+
+// Function local static, guarded by the compiler
+Config* meyersGet() {
+    static Config* instance = pc::Singleton<Config>::get();
+    return instance;
+}
+
+// Lock on every call
+Config* lockedGet() {
+    static std::mutex mtx;
+    std::lock_guard<std::mutex> lock(mtx);
+    return pc::Singleton<Config>::get();
+}
+
+template <typename Get>
+void getThroughput(const char* name, int threads, Get get) {
+    const double ms = measureThreadsMs(threads, [get](int) {
+        long sum = 0;
+        for (int i = 0; i < getsPerThread; ++i) {
+            sum += get()->value;
+            doNotOptimize(sum);
+        }
+    });
+    report(std::string(name) + ", threads=" + std::to_string(threads),
+        static_cast<std::size_t>(getsPerThread) * threads, ms);
+}
+
+constexpr std::size_t shapeTypes = 256;
+constexpr int lookups = 10000000;
+constexpr int creations = 2000000;
+
+template <std::size_t N>
+class NumberedShape final : public pc::Shape {
+public:
+    std::string draw() const override {
+        return "shape" + std::to_string(N);
+    }
+};
+
+using ShapeMap = std::unordered_map<std::string, std::function<pc::UniqueShape()>>;
+
+template <std::size_t... N>
+void registerShapes(pc::ShapeRegistry& registry, ShapeMap& map, std::index_sequence<N...>) {
+    using Expand = int[];
+    (void)Expand{(registry.add("shape" + std::to_string(N), []() -> pc::UniqueShape {
+        return std::make_unique<NumberedShape<N>>();
+    }), 0)...};
+    (void)Expand{(map.emplace("shape" + std::to_string(N), []() -> pc::UniqueShape {
+        return std::make_unique<NumberedShape<N>>();
+    }), 0)...};
+}
+
+// Keys arrive in a scrambled order, as they would from a config or the wire
+std::vector<std::string> shapeKeys() {
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < shapeTypes; ++i) {
+        keys.push_back("shape" + std::to_string((i * 97) % shapeTypes));
+    }
+    return keys;
+}
+
+template <typename Lookup>
+void keyedLookups(const std::string& name, int count, Lookup lookup) {
+    const auto keys = shapeKeys();
+    long sum = 0;
+    const double ms = measureMs([&]() {
+        for (int i = 0; i < count; ++i) {
+            sum += lookup(keys[i % shapeTypes]);
+        }
+    });
+    doNotOptimize(sum);
+    report(name, count, ms);
+}
+
+constexpr std::size_t batchShapes = 1000000;
+constexpr int shapeBatches = 10;
+
+constexpr int poolRounds = 200000;
+constexpr std::size_t poolBurst = 16;
+
+// Each round acquires a burst of objects, uses them and releases them all
+template <typename Acquire>
+void acquireRelease(const char* name, int threads, Acquire acquire) {
+    const double ms = measureThreadsMs(threads, [&acquire](int) {
+        using Handle = decltype(acquire());
+        std::vector<Handle> burst;
+        burst.reserve(poolBurst);
+        std::size_t drawn = 0;
+        for (int round = 0; round < poolRounds; ++round) {
+            for (std::size_t i = 0; i < poolBurst; ++i) {
+                burst.push_back(acquire());
+            }
+            drawn += burst.back()->draw().size();
+            burst.clear();
+        }
+        doNotOptimize(drawn);
+    });
+    report(std::string(name) + ", threads=" + std::to_string(threads),
+        static_cast<std::size_t>(poolRounds) * poolBurst * threads, ms);
+}
+
+constexpr std::size_t prototypeClones = 1000000;
+constexpr int cloneRounds = 5;
+
+// Clones copy a plain std::string name. The copy-on-write base name is empty
+// and shared, so the clones differ from PrototypeA clones only in the copy.
+class StringNamePrototype final : public pc::PrototypeA {
+private:
+    std::string _ownName;
+
+public:
+    StringNamePrototype(std::string name, int val, int valA)
+        : PrototypeA(std::string(), val, valA), _ownName(std::move(name)) { }
+
+    pc::UniquePrototype clone() const override {
+        return std::make_unique<StringNamePrototype>(*this);
+    }
+};
+
+constexpr int representationCalls = 2000000;
+
+constexpr int dinners = 2000000;
+
+// DinnerMenu as it was before interning: a string per item, joined with +=
+class StringDinnerMenu final {
+private:
+    std::vector<std::string> _menu;
+
+public:
+    void add(const std::string& item) {
+        this->_menu.emplace_back(item);
+    }
+
+    std::string menu() const {
+        std::string meal;
+        for (const auto& item : this->_menu) {
+            meal += item;
+            meal += ";";
+        }
+        if (!meal.empty()) {
+            meal.pop_back();
+        }
+        return meal;
+    }
+};
+
+template <typename Build, typename Render>
+void dinnerThroughput(const char* name, Build build, Render render) {
+    std::size_t allocations = allocationCount();
+    std::size_t length = 0;
+    double ms = measureMs([&]() {
+        for (int i = 0; i < dinners; ++i) {
+            length += render(build());
+        }
+    });
+    allocations = allocationCount() - allocations;
+    doNotOptimize(length);
+    report(std::string(name) + " build+render (" + std::to_string(allocations / dinners) + " allocations/dinner)",
+        dinners, ms);
+
+    const auto dinner = build();
+    ms = measureMs([&]() {
+        for (int i = 0; i < dinners; ++i) {
+            length += render(dinner);
+        }
+    });
+    doNotOptimize(length);
+    report(std::string(name) + " render", dinners, ms);
+}
+
+constexpr std::size_t dinnerBatch = 1000000;
+constexpr int batchRounds = 5;
+
+constexpr int exportRounds = 10;
+// Bytes written per item size, so long items do not make huge files
+constexpr std::size_t exportBytes = std::size_t(320) << 20;
+// 0 stands for the real BBQ menu, a few bytes per item
+constexpr std::size_t exportItemSizes[] = {0, 64, 256, 512, 1024, 4096};
+
+// Full dinners, three items of itemSize bytes each or the BBQ ones for 0
+std::vector<pc::DinnerMenu> exportedMenus(std::size_t itemSize, std::size_t count) {
+    std::vector<pc::DinnerMenu> menus(count);
+    if (itemSize == 0) {
+        pc::BbqDinnerBuilder builder;
+        pc::DinnerDirector director(&builder);
+        for (auto& menu : menus) {
+            director.fullDinner();
+            builder.getDinner(menu);
+        }
+        return menus;
+    }
+    const pc::MenuItemId items[] = {
+        pc::MenuItemTable::global().intern(std::string(itemSize, 'a')),
+        pc::MenuItemTable::global().intern(std::string(itemSize, 'b')),
+        pc::MenuItemTable::global().intern(std::string(itemSize, 'c'))
+    };
+    for (auto& menu : menus) {
+        for (const auto item : items) {
+            menu.add(item);
+        }
+    }
+    return menus;
+}
+
+constexpr int snapshotPrototypes = 10000;
+constexpr int startupRounds = 20;
+
+// What the registry looks like when every prototype is built in code
+std::vector<pc::UniquePrototype> buildPrototypes() {
+    std::vector<pc::UniquePrototype> prototypes;
+    prototypes.reserve(snapshotPrototypes);
+    for (int i = 0; i < snapshotPrototypes; ++i) {
+        const std::string name = "deployment/prototype/" + std::to_string(i);
+        if (i % 2 == 0) {
+            prototypes.push_back(std::make_unique<pc::PrototypeA>(name, i, i));
+        } else {
+            prototypes.push_back(std::make_unique<pc::PrototypeB>(name, i, i));
+        }
+    }
+    return prototypes;
+}
+
+}
+
+void shapeRegistryBenchmark() {
+    pc::ShapeRegistry registry;
+    ShapeMap map;
+    registerShapes(registry, map, std::make_index_sequence<shapeTypes>());
+
+    keyedLookups("unordered_map<string, function> find", lookups, [&map](const std::string& key) {
+        return static_cast<long>(map.find(key) != map.end());
+    });
+    keyedLookups("ShapeRegistry find (unfrozen)", lookups, [&registry](const std::string& key) {
+        return static_cast<long>(registry.find(key) != nullptr);
+    });
+    registry.freeze();
+    keyedLookups("ShapeRegistry find (perfect hash)", lookups, [&registry](const std::string& key) {
+        return static_cast<long>(registry.find(key) != nullptr);
+    });
+
+    keyedLookups("unordered_map<string, function> create", creations, [&map](const std::string& key) {
+        return static_cast<long>(map.at(key)() != nullptr);
+    });
+    keyedLookups("ShapeRegistry create (perfect hash)", creations, [&registry](const std::string& key) {
+        return static_cast<long>(registry.create(key) != nullptr);
+    });
+}
+
+void singletonBenchmark() {
+    for (int threads : threadCounts()) {
+        getThroughput("Singleton<T>::get", threads, []() { return pc::Singleton<Config>::get(); });
+        getThroughput("function local static", threads, meyersGet);
+        getThroughput("mutex per get", threads, lockedGet);
+    }
+}
+
+void shapeVariantBenchmark() {
+    const pc::TriangleFactory triangles;
+    const pc::RectangleFactory rectangles;
+    const pc::Factory* factories[] = {&triangles, &rectangles};
+
+    // Existing path: heap allocated shape and a new string per doWork()
+    std::string out;
+    std::size_t allocations = allocationCount();
+    double ms = measureMs([&]() {
+        for (int batch = 0; batch < shapeBatches; ++batch) {
+            out.clear();
+            for (std::size_t i = 0; i < batchShapes; ++i) {
+                out += factories[i & 1]->doWork();
+                out += "; ";
+            }
+        }
+    });
+    allocations = allocationCount() - allocations;
+    doNotOptimize(out.size());
+    report("Factory::doWork (" + std::to_string(allocations) + " allocations)", batchShapes * shapeBatches, ms);
+
+    // Contiguous values drawn into a preallocated buffer
+    pc::ShapeBatch shapes;
+    shapes.reserve(batchShapes);
+    for (std::size_t i = 0; i < batchShapes; ++i) {
+        shapes.add((i & 1) ? pc::ShapeVariant(pc::RectangleValue()) : pc::ShapeVariant(pc::TriangleValue()));
+    }
+    std::vector<char> buffer(shapes.drawnSize());
+    allocations = allocationCount();
+    ms = measureMs([&]() {
+        for (int batch = 0; batch < shapeBatches; ++batch) {
+            doNotOptimize(shapes.drawInto(buffer.data()));
+        }
+    });
+    allocations = allocationCount() - allocations;
+    report("ShapeBatch::drawInto (" + std::to_string(allocations) + " allocations)", batchShapes * shapeBatches, ms);
+}
+
+void objectPoolBenchmark() {
+    for (int threads : threadCounts()) {
+        acquireRelease("std::make_unique<Triangle>", threads, []() {
+            return std::make_unique<pc::Triangle>();
+        });
+        pc::ObjectPool<pc::Triangle> pool(poolBurst * 8 * threads, poolBurst * threads);
+        acquireRelease("ObjectPool<Triangle>::acquire", threads, [&pool]() {
+            return pool.acquire();
+        });
+    }
+}
+
+void prototypeBatchBenchmark() {
+    const pc::PrototypeFactory factory;
+
+    std::vector<pc::UniquePrototype> clones;
+    clones.reserve(prototypeClones);
+    std::size_t allocations = allocationCount();
+    double ms = measureMs([&]() {
+        for (int round = 0; round < cloneRounds; ++round) {
+            clones.clear();
+            for (std::size_t i = 0; i < prototypeClones; ++i) {
+                clones.push_back(factory.create(pc::PrototypeType::PrototypeTypeA));
+            }
+        }
+    });
+    allocations = allocationCount() - allocations;
+    doNotOptimize(clones.back());
+    report("create() x N (" + std::to_string(allocations) + " allocations)",
+        prototypeClones * cloneRounds, ms);
+    clones.clear();
+
+    pc::PrototypeBatch batch;
+    allocations = allocationCount();
+    ms = measureMs([&]() {
+        for (int round = 0; round < cloneRounds; ++round) {
+            factory.createBatch(pc::PrototypeType::PrototypeTypeA, prototypeClones, batch);
+        }
+    });
+    allocations = allocationCount() - allocations;
+    doNotOptimize(batch[0]);
+    report("createBatch (" + std::to_string(allocations) + " allocations)",
+        prototypeClones * cloneRounds, ms);
+}
+
+void prototypeCowBenchmark() {
+    // Long enough to live on the heap rather than in the small string buffer
+    const std::string name(200, 'p');
+
+    auto produce = [](const char* label, pc::UniquePrototype prototype) {
+        pc::PrototypeFactory factory;
+        factory.add(std::move(prototype));
+        std::vector<pc::UniquePrototype> clones;
+        clones.reserve(prototypeClones);
+        const std::size_t bytes = allocatedBytes();
+        const double ms = measureMs([&]() {
+            for (std::size_t i = 0; i < prototypeClones; ++i) {
+                clones.push_back(factory.create(pc::PrototypeType::PrototypeTypeA));
+            }
+        });
+        const std::size_t megabytes = (allocatedBytes() - bytes) >> 20;
+        report(std::string(label) + " (" + std::to_string(megabytes) + " MB)", prototypeClones, ms);
+    };
+
+    // What clone() did before the name became copy-on-write
+    produce("std::string name", std::make_unique<StringNamePrototype>(name, 1, 1));
+    produce("copy-on-write name", std::make_unique<pc::PrototypeA>(name, 1, 1));
+}
+
+void prototypeRepresentationBenchmark() {
+    // Longer than the small string buffer, like most names that get logged
+    const pc::PrototypeA prototype("logged/prototype/name", -12345, 67890);
+
+    auto run = [](const char* name, auto represent) {
+        std::size_t length = 0;
+        const std::size_t allocations = allocationCount();
+        const double ms = measureMs([&]() {
+            for (int i = 0; i < representationCalls; ++i) {
+                length += represent();
+            }
+        });
+        const double perCall = static_cast<double>(allocationCount() - allocations) / representationCalls;
+        doNotOptimize(length);
+        char label[96];
+        std::snprintf(label, sizeof(label), "%s (%.2f allocations/call)", name, perCall);
+        report(label, representationCalls, ms);
+    };
+
+    // What representation() did before it formatted into a buffer
+    run("operator+ and to_string", [&prototype]() {
+        const std::string text = "Name: " + prototype.name() + " Val: " + std::to_string(prototype.val()) +
+            " ValA: " + std::to_string(prototype.valA());
+        return text.size();
+    });
+    run("representation()", [&prototype]() {
+        return prototype.representation().size();
+    });
+    std::string buffer;
+    run("representInto(reused buffer)", [&prototype, &buffer]() {
+        buffer.clear();
+        prototype.representInto(buffer);
+        return buffer.size();
+    });
+}
+
+void dinnerMenuBenchmark() {
+    dinnerThroughput("string items", []() {
+        auto dinner = std::make_unique<StringDinnerMenu>();
+        dinner->add("shrimp cocktail");
+        dinner->add("bbq ribs");
+        dinner->add("ice cream");
+        return dinner;
+    }, [](const auto& dinner) {
+        return dinner->menu().size();
+    });
+
+    pc::BbqDinnerBuilder builder;
+    pc::DinnerDirector director(&builder);
+    dinnerThroughput("interned items", [&]() {
+        director.fullDinner();
+        return builder.getDinner();
+    }, [](const auto& dinner) {
+        return dinner->menu().size();
+    });
+}
+
+void dinnerBatchBenchmark() {
+    // Baseline: one director, a fresh heap allocated dinner per getDinner()
+    pc::BbqDinnerBuilder builder;
+    pc::DinnerDirector director(&builder);
+    std::vector<pc::UniqueDinner> serial(dinnerBatch);
+    std::size_t allocations = allocationCount();
+    double ms = measureMs([&]() {
+        for (int round = 0; round < batchRounds; ++round) {
+            for (auto& dinner : serial) {
+                director.fullDinner();
+                dinner = builder.getDinner();
+            }
+        }
+    });
+    allocations = allocationCount() - allocations;
+    report("serial getDinner() (" + std::to_string(allocations) + " allocations)",
+        dinnerBatch * batchRounds, ms);
+    serial.clear();
+
+    for (int threads : threadCounts()) {
+        patterns::concurrency::ThreadPool pool(threads);
+        pc::BatchDinnerDirector batchDirector(pool, []() {
+            return std::make_unique<pc::BbqDinnerBuilder>();
+        });
+        std::vector<pc::DinnerMenu> dinners;
+        // Warm up so the measured rounds run on recycled storage
+        batchDirector.produce(dinnerBatch, &pc::DinnerDirector::fullDinner, dinners);
+
+        allocations = allocationCount();
+        ms = measureMs([&]() {
+            for (int round = 0; round < batchRounds; ++round) {
+                batchDirector.produce(dinnerBatch, &pc::DinnerDirector::fullDinner, dinners);
+            }
+        });
+        allocations = allocationCount() - allocations;
+        report("batch produce, threads=" + std::to_string(threads) + " (" + std::to_string(allocations) +
+            " allocations)", dinnerBatch * batchRounds, ms);
+    }
+}
+
+void menuExportBenchmark() {
+    const std::string path = uniqueTempPath("menu_export_bench");
+
+    for (const std::size_t itemSize : exportItemSizes) {
+        const std::string items = (itemSize == 0) ? std::string("bbq items") : (std::to_string(itemSize) + "B items");
+        const std::size_t lineSize = (itemSize == 0) ? 35 : (3 * itemSize + 3);
+        const int rounds = (itemSize == 0) ? exportRounds : 1;
+        const auto menus = exportedMenus(itemSize, (itemSize == 0) ? dinnerBatch : exportBytes / lineSize);
+
+        const auto exported = [&](const std::string& name, double ms) {
+            const auto megabytes = std::filesystem::file_size(path) >> 20;
+            report(name + ", " + items + " (" + std::to_string(megabytes) + " MB)", menus.size() * rounds, ms);
+            std::remove(path.c_str());
+        };
+
+        double ms = measureMs([&]() {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            for (int round = 0; round < rounds; ++round) {
+                for (const auto& dinner : menus) {
+                    out << dinner.menu() << '\n';
+                }
+            }
+        });
+        exported("menu() + ofstream", ms);
+
+        // Gather every piece, copy every piece, then the default threshold
+        const std::pair<const char*, std::size_t> thresholds[] = {
+            {"MenuExporter gather all", 0},
+            {"MenuExporter copy all", SIZE_MAX},
+            {"MenuExporter default threshold", pc::MenuExporter::defaultCopyThreshold}
+        };
+        for (const auto& [name, threshold] : thresholds) {
+            ms = measureMs([&, threshold = threshold]() {
+                const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                {
+                    pc::MenuExporter exporter(fd, threshold);
+                    for (int round = 0; round < rounds; ++round) {
+                        for (const auto& dinner : menus) {
+                            exporter.write(dinner);
+                        }
+                    }
+                    exporter.flush();
+                }
+                ::close(fd);
+            });
+            exported(name, ms);
+        }
+    }
+}
+
+void prototypeSnapshotBenchmark() {
+    const std::string path = uniqueTempPath("prototype_snapshot_bench");
+    {
+        pc::PrototypeSnapshotWriter writer;
+        for (const auto& prototype : buildPrototypes()) {
+            writer.add(*prototype);
+        }
+        writer.write(path);
+    }
+
+    double ms = measureMs([]() {
+        for (int round = 0; round < startupRounds; ++round) {
+            doNotOptimize(buildPrototypes().size());
+        }
+    });
+    report("construct in code", static_cast<std::size_t>(snapshotPrototypes) * startupRounds, ms);
+
+    // Load plus one pass over the bytes of every name so the mapping is really read
+    ms = measureMs([&path]() {
+        for (int round = 0; round < startupRounds; ++round) {
+            pc::PrototypeSnapshot snapshot(path);
+            std::size_t checksum = 0;
+            for (std::size_t i = 0; i < snapshot.size(); ++i) {
+                for (const char c : snapshot.name(i)) {
+                    checksum += static_cast<unsigned char>(c);
+                }
+            }
+            doNotOptimize(checksum);
+        }
+    });
+    report("mmap snapshot", static_cast<std::size_t>(snapshotPrototypes) * startupRounds, ms);
+
+    std::remove(path.c_str());
+}
+
+}
@@ -0,0 +1,51 @@
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+
+namespace {
+
+namespace pb = patterns::benchmarks;
+
+using Suite = std::pair<const char*, void (*)()>;
+
+const std::vector<Suite> suites = {
+    {"shared_ptr_policy", pb::sharedPtrPolicyBenchmark},
+    {"make_shared", pb::makeSharedBenchmark},
+    {"intrusive_ptr", pb::intrusivePtrBenchmark},
+    {"atomic_shared_ptr", pb::atomicSharedPtrBenchmark},
+    {"singleton", pb::singletonBenchmark},
+    {"shape_registry", pb::shapeRegistryBenchmark},
+    {"shape_variant", pb::shapeVariantBenchmark},
+    {"object_pool", pb::objectPoolBenchmark},
+    {"prototype_batch", pb::prototypeBatchBenchmark},
+    {"prototype_cow", pb::prototypeCowBenchmark},
+    {"prototype_representation", pb::prototypeRepresentationBenchmark},
+    {"prototype_snapshot", pb::prototypeSnapshotBenchmark},
+    {"dinner_menu", pb::dinnerMenuBenchmark},
+    {"dinner_batch", pb::dinnerBatchBenchmark},
+    {"menu_export", pb::menuExportBenchmark},
+    {"caching_proxy", pb::cachingProxyBenchmark},
+    {"allowlist", pb::allowlistBenchmark},
+    {"coalescing_proxy", pb::coalescingProxyBenchmark},
+    {"rate_limiting_proxy", pb::rateLimitingProxyBenchmark},
+    {"lazy_proxy", pb::lazyProxyBenchmark},
+    {"async_request", pb::asyncRequestBenchmark},
+};
+
+}
+
+// Usage: bench [suite name filter]
+int main(int argc, char** argv) {
+    const char* filter = (argc > 1) ? argv[1] : "";
+    for (const auto& suite : suites) {
+        if (std::strstr(suite.first, filter) == nullptr) {
+            continue;
+        }
+        std::cout << "== " << suite.first << std::endl;
+        suite.second();
+    }
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "benchmark.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../pointers/intrusive/custom_intrusive_ptr.h"
+#include "../pointers/shared/atomic_custom_shared_ptr.h"
+#include "../pointers/shared/custom_shared_ptr.h"
+
+namespace patterns::benchmarks {
+
+namespace {
+
+namespace pp = patterns::pointers;
+
+constexpr int copiesPerThread = 2000000;
+
+// Every slot assignment is one copy plus one destroy of the previous value
+template <typename Ptr>
+void copyDestroyLoop(const Ptr& source, int copies) {
+    std::array<Ptr, 64> ring;
+    for (int i = 0; i < copies; ++i) {
+        ring[i & 63] = source;
+    }
+    doNotOptimize(ring[0]);
+}
+
+template <typename RefCount>
+void privateCopyDestroy(const char* name, int threads) {
+    const double ms = measureThreadsMs(threads, [](int) {
+        pp::CustomSharedPtr<int, RefCount> ptr(new int(1));
+        copyDestroyLoop(ptr, copiesPerThread);
+    });
+    report(std::string(name) + " private, threads=" + std::to_string(threads),
+        static_cast<std::size_t>(copiesPerThread) * threads, ms);
+}
+
+void sharedCopyDestroy(int threads) {
+    pp::CustomSharedPtr<int, pp::AtomicRefCount> ptr(new int(1));
+    const double ms = measureThreadsMs(threads, [&ptr](int) {
+        copyDestroyLoop(ptr, copiesPerThread);
+    });
+    report("atomic shared, threads=" + std::to_string(threads),
+        static_cast<std::size_t>(copiesPerThread) * threads, ms);
+}
+
+constexpr int sharedObjects = 1000000;
+constexpr int copyRounds = 10;
+
+struct Payload {
+    long value;
+    explicit Payload(long value) : value(value) { }
+};
+
+// Creation cost and allocation count, then a pass that copies every pointer
+// and reads through it
+template <typename Create>
+void allocationAndThroughput(const char* name, Create create) {
+    std::vector<pp::CustomSharedPtr<Payload>> ptrs;
+    ptrs.reserve(sharedObjects);
+
+    const std::size_t allocationsBefore = allocationCount();
+    const double createMs = measureMs([&]() {
+        for (int i = 0; i < sharedObjects; ++i) {
+            ptrs.push_back(create(i));
+        }
+    });
+    const std::size_t allocations = allocationCount() - allocationsBefore;
+    report(std::string(name) + " create (" + std::to_string(allocations) + " allocations)",
+        sharedObjects, createMs);
+
+    std::vector<pp::CustomSharedPtr<Payload>> copies(sharedObjects);
+    long sum = 0;
+    const double copyMs = measureMs([&]() {
+        for (int round = 0; round < copyRounds; ++round) {
+            for (int i = 0; i < sharedObjects; ++i) {
+                copies[i] = ptrs[i];
+                sum += copies[i]->value;
+            }
+        }
+    });
+    doNotOptimize(sum);
+    report(std::string(name) + " copy+deref", static_cast<std::size_t>(sharedObjects) * copyRounds, copyMs);
+}
+
+constexpr int graphNodes = 100000;
+constexpr int graphCopies = 50;
+
+struct Node {
+    long value;
+    explicit Node(long value) : value(value) { }
+};
+
+template <typename RefCount>
+struct CountedNode final : pp::RefCounted<CountedNode<RefCount>, RefCount> {
+    long value;
+    explicit CountedNode(long value) : value(value) { }
+};
+
+// Copies a whole vector of pointers repeatedly, the way object graphs get
+// snapshotted, and sums the pointees so every copy is read
+template <typename Ptr, typename Make>
+void vectorCopies(const std::string& name, Make make) {
+    std::vector<Ptr> source;
+    source.reserve(graphNodes);
+    for (int i = 0; i < graphNodes; ++i) {
+        source.push_back(make(i));
+    }
+
+    long sum = 0;
+    const double ms = measureMs([&]() {
+        for (int round = 0; round < graphCopies; ++round) {
+            std::vector<Ptr> copy(source);
+            for (const auto& ptr : copy) {
+                sum += ptr->value;
+            }
+        }
+    });
+    doNotOptimize(sum);
+    report(name + " (" + std::to_string(sizeof(Ptr)) + " bytes)",
+        static_cast<std::size_t>(graphNodes) * graphCopies, ms);
+}
+
+template <typename RefCount>
+void intrusiveAgainstShared(const std::string& policy) {
+    using Shared = pp::CustomSharedPtr<Node, RefCount>;
+    using Intrusive = pp::CustomIntrusivePtr<CountedNode<RefCount>>;
+
+    vectorCopies<Shared>(policy + " CustomSharedPtr(new)", [](long i) {
+        return Shared(new Node(i));
+    });
+    vectorCopies<Shared>(policy + " makeCustomShared", [](long i) {
+        return pp::makeCustomShared<Node, RefCount>(i);
+    });
+    vectorCopies<Intrusive>(policy + " CustomIntrusivePtr", [](long i) {
+        return pp::makeCustomIntrusive<CountedNode<RefCount>>(i);
+    });
+}
+
+constexpr int loadsPerReader = 500000;
+
+using Allowlist = std::unordered_set<std::string>;
+using SharedAllowlist = pp::CustomSharedPtr<Allowlist>;
+
+SharedAllowlist makeAllowlist(int generation) {
+    auto allowlist = pp::makeCustomShared<Allowlist>();
+    for (int i = 0; i < 16; ++i) {
+        allowlist->insert("service" + std::to_string(generation + i));
+    }
+    return allowlist;
+}
+
+// Snapshot holder guarded by a mutex, the baseline readers have to lock
+class LockedAllowlist {
+private:
+    mutable std::mutex mtx;
+    SharedAllowlist current;
+
+public:
+    explicit LockedAllowlist(SharedAllowlist allowlist) : current(std::move(allowlist)) { }
+
+    SharedAllowlist load() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return current;
+    }
+
+    void store(SharedAllowlist allowlist) {
+        std::lock_guard<std::mutex> lock(mtx);
+        current = std::move(allowlist);
+    }
+};
+
+// Readers look names up in the current snapshot while one writer keeps
+// publishing new snapshots until every reader is done
+template <typename Holder>
+void readersWithWriter(const char* name, int readers) {
+    Holder holder(makeAllowlist(0));
+    std::atomic<bool> done(false);
+    std::thread writer([&holder, &done]() {
+        int generation = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+            holder.store(makeAllowlist(++generation % 64));
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    std::atomic<long> found(0);
+    const double ms = measureThreadsMs(readers, [&holder, &found](int index) {
+        const std::string key = "service" + std::to_string(20 + index);
+        long hits = 0;
+        for (int i = 0; i < loadsPerReader; ++i) {
+            auto snapshot = holder.load();
+            hits += static_cast<long>(snapshot->count(key));
+        }
+        found.fetch_add(hits, std::memory_order_relaxed);
+    });
+    done.store(true);
+    writer.join();
+
+    doNotOptimize(found.load());
+    report(std::string(name) + ", readers=" + std::to_string(readers),
+        static_cast<std::size_t>(loadsPerReader) * readers, ms);
+}
+
+}
+
+void sharedPtrPolicyBenchmark() {
+    for (int threads : threadCounts()) {
+        privateCopyDestroy<pp::NonAtomicRefCount>("non-atomic", threads);
+        privateCopyDestroy<pp::AtomicRefCount>("atomic", threads);
+        sharedCopyDestroy(threads);
+    }
+}
+
+void makeSharedBenchmark() {
+    allocationAndThroughput("new + CustomSharedPtr", [](long i) {
+        return pp::CustomSharedPtr<Payload>(new Payload(i));
+    });
+    allocationAndThroughput("makeCustomShared", [](long i) {
+        return pp::makeCustomShared<Payload>(i);
+    });
+    allocationAndThroughput("allocateCustomShared", [](long i) {
+        return pp::allocateCustomShared<Payload>(std::allocator<Payload>(), i);
+    });
+}
+
+void intrusivePtrBenchmark() {
+    intrusiveAgainstShared<pp::NonAtomicRefCount>("non-atomic");
+    intrusiveAgainstShared<pp::AtomicRefCount>("atomic");
+}
+
+void atomicSharedPtrBenchmark() {
+    for (int readers : threadCounts()) {
+        readersWithWriter<LockedAllowlist>("mutex + CustomSharedPtr", readers);
+        readersWithWriter<pp::AtomicCustomSharedPtr<Allowlist>>("AtomicCustomSharedPtr", readers);
+    }
+}
+
+}
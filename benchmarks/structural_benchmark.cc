@@ -0,0 +1,506 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "../concurrency/executor.h"
+#include "../concurrency/task.h"
+#include "../concurrency/thread_pool.h"
+#include "../structural/proxy/allowlist.h"
+#include "../structural/proxy/caching_proxy.h"
+#include "../structural/proxy/coalescing_proxy.h"
+#include "../structural/proxy/proxy.h"
+#include "../structural/proxy/rate_limiting_proxy.h"
+
+namespace patterns::benchmarks {
+
+namespace {
+
+namespace ps = patterns::structural;
+
+// Backend that burns a fixed amount of CPU per request, like a slow lookup
+class SlowService final : public ps::Service {
+private:
+    std::chrono::microseconds _cost;
+
+public:
+    mutable std::atomic<long> calls{0};
+
+    explicit SlowService(std::chrono::microseconds cost) : ps::Service("slow"), _cost(cost) { }
+
+    std::string request() const override {
+        return this->request(std::string());
+    }
+
+    std::string request(const std::string& query) const override {
+        ++this->calls;
+        const auto until = std::chrono::steady_clock::now() + this->_cost;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+        return this->_name + "/" + query;
+    }
+};
+
+// Queries drawn from a Zipf distribution over distinct keys: a few are very
+// popular and there is a long tail, like most request traffic
+std::vector<std::string> zipfQueries(std::size_t keys, double exponent, std::size_t count, unsigned seed) {
+    std::vector<double> cdf(keys);
+    double sum = 0;
+    for (std::size_t i = 0; i < keys; ++i) {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+        cdf[i] = sum;
+    }
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<std::string> queries;
+    queries.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) - cdf.begin();
+        queries.push_back("key" + std::to_string(rank));
+    }
+    return queries;
+}
+
+constexpr std::size_t zipfKeys = 100000;
+constexpr std::size_t queriesPerThread = 100000;
+constexpr auto slowCost = std::chrono::microseconds(5);
+
+// Every thread replays its own Zipf stream against service
+void zipfRequests(const std::string& name, const ps::Service& service, const SlowService& backend, int threads) {
+    std::vector<std::vector<std::string>> streams;
+    for (int i = 0; i < threads; ++i) {
+        streams.push_back(zipfQueries(zipfKeys, 0.99, queriesPerThread, 17 + i));
+    }
+
+    const long callsBefore = backend.calls;
+    const double ms = measureThreadsMs(threads, [&service, &streams](int index) {
+        std::size_t length = 0;
+        for (const auto& query : streams[index]) {
+            length += service.request(query).size();
+        }
+        doNotOptimize(length);
+    });
+    const std::size_t requests = queriesPerThread * threads;
+    const auto calls = static_cast<std::size_t>(backend.calls - callsBefore);
+    report(name + ", threads=" + std::to_string(threads) + " (hit rate " +
+        std::to_string(100 * (requests - calls) / requests) + "%)", requests, ms);
+}
+
+constexpr int requestsPerThread = 1000000;
+
+using Names = std::unordered_set<std::string>;
+
+Names allowlistNames(int generation) {
+    Names names;
+    for (int i = 0; i < 1000; ++i) {
+        names.insert("service" + std::to_string(generation + i));
+    }
+    // The proxies under test stay allowed across reloads
+    names.insert("proxy");
+    return names;
+}
+
+// What Proxy did before: hash its own name into an unordered_set on every
+// request, here behind a mutex so the set can be reloaded
+class LockedProxy final : public ps::Service {
+private:
+    mutable std::mutex _mtx;
+    Names _allowed;
+    ps::ServiceA _service;
+
+public:
+    explicit LockedProxy(std::string name) : ps::Service(name), _allowed(allowlistNames(0)), _service(name) { }
+
+    std::string request() const override {
+        {
+            std::lock_guard<std::mutex> lock(this->_mtx);
+            if (this->_allowed.find(this->_name) == this->_allowed.end()) {
+                return {};
+            }
+        }
+        return this->_service.request();
+    }
+
+    void reload(Names names) {
+        std::lock_guard<std::mutex> lock(this->_mtx);
+        this->_allowed = std::move(names);
+    }
+};
+
+// Callers hammer request() while a writer reloads the allowlist every 100us
+template <typename Proxy, typename Reload>
+void requestsWithReloads(const char* name, const Proxy& proxy, Reload reload, int threads) {
+    std::atomic<bool> done(false);
+    std::atomic<int> reloads(0);
+    // Lists are built up front so the writer only swaps
+    std::vector<Names> lists = {allowlistNames(0), allowlistNames(1)};
+    std::thread writer([&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            reload(lists[++reloads % 2]);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    const double ms = measureThreadsMs(threads, [&proxy](int) {
+        std::size_t length = 0;
+        for (int i = 0; i < requestsPerThread; ++i) {
+            length += proxy.request().size();
+        }
+        doNotOptimize(length);
+    });
+    done.store(true);
+    writer.join();
+    report(std::string(name) + ", threads=" + std::to_string(threads) + " (" + std::to_string(reloads) +
+        " reloads)", static_cast<std::size_t>(requestsPerThread) * threads, ms);
+}
+
+constexpr int lookupRounds = 200;
+
+template <typename Set>
+void lookups(const char* name, const Set& set, const std::vector<std::string>& queries) {
+    long found = 0;
+    const double ms = measureMs([&]() {
+        for (int round = 0; round < lookupRounds; ++round) {
+            for (const auto& query : queries) {
+                found += set.count(query);
+            }
+        }
+    });
+    doNotOptimize(found);
+    report(name, queries.size() * lookupRounds, ms);
+}
+
+// Allowlist spelled like a set for lookups()
+struct CompactSet {
+    ps::Allowlist allowlist;
+
+    std::size_t count(const std::string& name) const {
+        return this->allowlist.contains(name) ? 1 : 0;
+    }
+};
+
+// ServiceA behind a network hop: every request waits a fixed latency and
+// at most connections requests are served at once, the rest queue up
+class RemoteServiceA final : public ps::ServiceA {
+private:
+    std::chrono::microseconds _latency;
+    mutable std::mutex _mtx;
+    mutable std::condition_variable _released;
+    mutable int _free;
+
+public:
+    mutable std::atomic<long> calls{0};
+
+    RemoteServiceA(std::chrono::microseconds latency, int connections)
+        : ps::ServiceA("remote"), _latency(latency), _free(connections) { }
+
+    using ps::ServiceA::request;
+
+    std::string request(const std::string& query) const override {
+        ++this->calls;
+        {
+            std::unique_lock<std::mutex> lock(this->_mtx);
+            this->_released.wait(lock, [this]() {
+                return this->_free > 0;
+            });
+            --this->_free;
+        }
+        std::this_thread::sleep_for(this->_latency);
+        {
+            std::lock_guard<std::mutex> lock(this->_mtx);
+            ++this->_free;
+        }
+        this->_released.notify_one();
+        return ps::ServiceA::request(query);
+    }
+};
+
+constexpr int requestsPerCaller = 20;
+constexpr int hotKeys = 4;
+constexpr auto remoteLatency = std::chrono::milliseconds(1);
+constexpr int remoteConnections = 8;
+
+// Many callers asking for a handful of hot keys at once, reports backend
+// calls and the median and tail latency of a single request
+void concurrentCallers(const std::string& name, const ps::Service& service, const RemoteServiceA& backend,
+    int callers) {
+    std::vector<std::vector<double>> latencies(callers);
+    const long callsBefore = backend.calls;
+    const double ms = measureThreadsMs(callers, [&service, &latencies](int index) {
+        std::size_t length = 0;
+        for (int i = 0; i < requestsPerCaller; ++i) {
+            const std::string query = "key" + std::to_string((index + i) % hotKeys);
+            latencies[index].push_back(measureMs([&]() {
+                length += service.request(query).size();
+            }));
+        }
+        doNotOptimize(length);
+    });
+
+    std::vector<double> all;
+    for (const auto& own : latencies) {
+        all.insert(all.end(), own.begin(), own.end());
+    }
+    std::sort(all.begin(), all.end());
+    char label[160];
+    std::snprintf(label, sizeof(label), "%s, callers=%d (%ld backend calls, p50 %.2f ms, p99 %.2f ms)",
+        name.c_str(), callers, backend.calls - callsBefore, all[all.size() / 2], all[all.size() * 99 / 100]);
+    report(label, all.size(), ms);
+}
+
+constexpr int decisionsPerThread = 2000000;
+constexpr double decisionRate = 1e6;
+constexpr std::size_t decisionBurst = 1000;
+
+// Token bucket with a count and a refill time behind a mutex, the usual
+// baseline for the single word bucket
+class LockedTokenBucket final {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::mutex _mtx;
+    double _tokens;
+    Clock::time_point _refilled;
+
+public:
+    LockedTokenBucket() : _tokens(decisionBurst), _refilled(Clock::now()) { }
+
+    bool tryTake() {
+        const auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(this->_mtx);
+        const double elapsed = std::chrono::duration<double>(now - this->_refilled).count();
+        this->_tokens = std::min<double>(decisionBurst, this->_tokens + elapsed * decisionRate);
+        this->_refilled = now;
+        if (this->_tokens < 1) {
+            return false;
+        }
+        this->_tokens -= 1;
+        return true;
+    }
+};
+
+// Admit or reject decisions per second, reports how many were admitted
+template <typename Decide>
+void decisions(const std::string& name, int threads, Decide decide) {
+    std::atomic<long> admitted(0);
+    const double ms = measureThreadsMs(threads, [&decide, &admitted](int index) {
+        long own = 0;
+        for (int i = 0; i < decisionsPerThread; ++i) {
+            own += decide(index) ? 1 : 0;
+        }
+        admitted += own;
+    });
+    const std::size_t total = static_cast<std::size_t>(decisionsPerThread) * threads;
+    report(name + ", threads=" + std::to_string(threads) + " (" +
+        std::to_string(100 * admitted.load() / static_cast<long>(total)) + "% admitted)", total, ms);
+}
+
+constexpr int lazyProxies = 5000;
+constexpr auto serviceStartup = std::chrono::microseconds(50);
+constexpr int warmRequests = 200;
+
+// ServiceA whose construction does expensive setup, like opening connections
+ps::UniqueServiceA expensiveServiceA(const std::string& name) {
+    const auto until = std::chrono::steady_clock::now() + serviceStartup;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+    return std::make_unique<ps::ServiceA>(name);
+}
+
+// Startup of every proxy, then the first and later requests of each one
+void proxyStartup(const char* name, ps::Construction construction, bool prewarm) {
+    auto allowlist = pointers::makeCustomShared<ps::ReloadableAllowlist>(Names{"proxy"});
+    patterns::concurrency::ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::unique_ptr<ps::Proxy>> proxies;
+    proxies.reserve(lazyProxies);
+
+    const double startupMs = measureMs([&]() {
+        for (int i = 0; i < lazyProxies; ++i) {
+            proxies.push_back(std::make_unique<ps::Proxy>("proxy", allowlist, construction, expensiveServiceA));
+            if (prewarm) {
+                proxies.back()->prewarm(pool);
+            }
+        }
+    });
+    report(std::string(name) + " startup", lazyProxies, startupMs);
+    pool.wait();
+
+    std::size_t length = 0;
+    const double firstMs = measureMs([&]() {
+        for (const auto& proxy : proxies) {
+            length += proxy->request().size();
+        }
+    });
+    report(std::string(name) + " first request", lazyProxies, firstMs);
+
+    const double laterMs = measureMs([&]() {
+        for (int round = 0; round < warmRequests; ++round) {
+            for (const auto& proxy : proxies) {
+                length += proxy->request().size();
+            }
+        }
+    });
+    doNotOptimize(length);
+    report(std::string(name) + " later requests", static_cast<std::size_t>(lazyProxies) * warmRequests, laterMs);
+}
+
+constexpr int ioRequests = 20000;
+constexpr int threadsInFlight = 1000;
+constexpr auto ioLatency = std::chrono::milliseconds(1);
+
+// Service whose requests mostly wait on I/O. request() blocks its thread for
+// the latency, asyncRequest() waits on the executor timer instead.
+class IoBoundService final : public ps::Service {
+public:
+    IoBoundService() : ps::Service("io") { }
+
+    using ps::Service::request;
+
+    std::string request() const override {
+        std::this_thread::sleep_for(ioLatency);
+        return this->_name;
+    }
+
+    patterns::concurrency::Task<std::string> asyncRequest(std::string query,
+        patterns::concurrency::Executor& executor) const override {
+        co_await executor.sleepFor(ioLatency);
+        co_return this->_name + "/" + query;
+    }
+};
+
+patterns::concurrency::Task<void> asyncClient(const ps::Service& service, patterns::concurrency::Executor& executor,
+    std::atomic<std::size_t>& length, std::latch& done) {
+    const std::string response = co_await service.asyncRequest("key", executor);
+    length.fetch_add(response.size(), std::memory_order_relaxed);
+    done.count_down();
+}
+
+}
+
+void cachingProxyBenchmark() {
+    for (int threads : threadCounts()) {
+        auto backend = std::make_unique<SlowService>(slowCost);
+        zipfRequests("uncached", *backend, *backend, threads);
+
+        for (std::size_t capacity : {1000, 10000}) {
+            auto service = std::make_unique<SlowService>(slowCost);
+            const SlowService& counted = *service;
+            ps::CachingProxy proxy("cache", std::move(service), capacity, std::chrono::seconds(60));
+            zipfRequests("CachingProxy capacity=" + std::to_string(capacity), proxy, counted, threads);
+        }
+    }
+}
+
+void allowlistBenchmark() {
+    for (int threads : threadCounts()) {
+        LockedProxy locked("proxy");
+        requestsWithReloads("mutex + unordered_set", locked, [&locked](const Names& names) {
+            locked.reload(names);
+        }, threads);
+
+        ps::Proxy proxy("proxy", allowlistNames(0));
+        requestsWithReloads("Proxy cached decision", proxy, [&proxy](const Names& names) {
+            proxy.allowlist()->reload(names);
+        }, threads);
+    }
+
+    // Lookups of other names, half of them allowed
+    const Names names = allowlistNames(0);
+    std::vector<std::string> queries;
+    for (int i = 0; i < 2000; ++i) {
+        queries.push_back("service" + std::to_string(i));
+    }
+    lookups("unordered_set lookups", names, queries);
+    lookups("Allowlist lookups", CompactSet{ps::Allowlist(names)}, queries);
+}
+
+void coalescingProxyBenchmark() {
+    for (int callers : {64, 128}) {
+        const RemoteServiceA direct(remoteLatency, remoteConnections);
+        concurrentCallers("direct", direct, direct, callers);
+
+        auto service = std::make_unique<RemoteServiceA>(remoteLatency, remoteConnections);
+        const RemoteServiceA& backend = *service;
+        const ps::CoalescingProxy proxy("coalescing", std::move(service));
+        concurrentCallers("CoalescingProxy", proxy, backend, callers);
+    }
+}
+
+void rateLimitingProxyBenchmark() {
+    for (int threads : threadCounts()) {
+        LockedTokenBucket locked;
+        decisions("mutex bucket, one caller", threads, [&locked](int) {
+            return locked.tryTake();
+        });
+
+        // One bucket shared by every thread, the most contended case
+        auto limiter = pointers::makeCustomShared<ps::RateLimiter>(decisionRate, decisionBurst);
+        const ps::RateLimitingProxy shared("caller", std::make_unique<ps::ServiceA>("serviceA"), limiter);
+        decisions("RateLimitingProxy, one caller", threads, [&shared](int) {
+            return !shared.request().empty();
+        });
+
+        // A caller per thread, buckets never contend
+        std::vector<std::unique_ptr<ps::RateLimitingProxy>> callers;
+        for (int i = 0; i < threads; ++i) {
+            callers.push_back(std::make_unique<ps::RateLimitingProxy>("caller" + std::to_string(i),
+                std::make_unique<ps::ServiceA>("serviceA"), limiter));
+        }
+        decisions("RateLimitingProxy, caller per thread", threads, [&callers](int index) {
+            return !callers[index]->request().empty();
+        });
+    }
+}
+
+void lazyProxyBenchmark() {
+    proxyStartup("eager", ps::Construction::Eager, false);
+    proxyStartup("lazy", ps::Construction::Lazy, false);
+    proxyStartup("lazy + prewarm", ps::Construction::Lazy, true);
+}
+
+void asyncRequestBenchmark() {
+    const IoBoundService service;
+
+    // A thread per request, at most threadsInFlight of them at a time
+    std::atomic<std::size_t> length(0);
+    double ms = measureMs([&]() {
+        for (int wave = 0; wave < ioRequests / threadsInFlight; ++wave) {
+            measureThreadsMs(threadsInFlight, [&service, &length](int) {
+                length.fetch_add(service.request("key").size(), std::memory_order_relaxed);
+            });
+        }
+    });
+    report("thread per request (" + std::to_string(threadsInFlight) + " in flight)", ioRequests, ms);
+
+    // Every request outstanding at once on a few threads
+    for (int threads : threadCounts()) {
+        std::latch done(ioRequests);
+        {
+            patterns::concurrency::Executor executor(threads);
+            ms = measureMs([&]() {
+                for (int i = 0; i < ioRequests; ++i) {
+                    executor.spawn(asyncClient(service, executor, length, done));
+                }
+                done.wait();
+            });
+        }
+        report("asyncRequest coroutines, threads=" + std::to_string(threads) + " (" +
+            std::to_string(ioRequests) + " in flight)", ioRequests, ms);
+    }
+    doNotOptimize(length.load());
+}
+
+}
@@ -0,0 +1,70 @@
+#include "executor.h"
+
+namespace patterns::concurrency {
+
+Executor::Executor(std::size_t threads) : _pool(threads), _timerThread(&Executor::runTimers, this) { }
+
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lock(this->_mtx);
+        this->_stopping = true;
+    }
+    this->_timersChanged.notify_one();
+    this->_timerThread.join();
+}
+
+void Executor::runTimers() {
+    std::unique_lock<std::mutex> lock(this->_mtx);
+    while (!this->_stopping) {
+        if (this->_timers.empty()) {
+            this->_timersChanged.wait(lock);
+            continue;
+        }
+        const auto first = this->_timers.begin();
+        if (first->first > Clock::now()) {
+            this->_timersChanged.wait_until(lock, first->first);
+            continue;
+        }
+
+        auto task = std::move(first->second);
+        this->_timers.erase(first);
+        lock.unlock();
+        this->_pool.submit(std::move(task));
+        lock.lock();
+    }
+}
+
+std::size_t Executor::size() const {
+    return this->_pool.size();
+}
+
+void Executor::post(std::function<void()> task) {
+    this->_pool.submit(std::move(task));
+}
+
+void Executor::postAt(Clock::time_point at, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(this->_mtx);
+        this->_timers.emplace(at, std::move(task));
+    }
+    this->_timersChanged.notify_one();
+}
+
+Executor::ScheduleAwaiter Executor::schedule() {
+    return ScheduleAwaiter{*this};
+}
+
+Executor::SleepAwaiter Executor::sleepFor(Clock::duration duration) {
+    return SleepAwaiter{*this, Clock::now() + duration};
+}
+
+Detached Executor::run(Executor& executor, Task<void> task) {
+    co_await executor.schedule();
+    co_await task;
+}
+
+void Executor::spawn(Task<void> task) {
+    run(*this, std::move(task));
+}
+
+}
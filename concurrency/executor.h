@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "task.h"
+#include "thread_pool.h"
+
+namespace patterns::concurrency {
+
+// Thread pool plus a timer queue for resuming coroutines. A coroutine that
+// waits on a timer holds no thread, so a few workers can keep thousands of
+// timed waits, such as simulated I/O, outstanding at once.
+class Executor final {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    std::mutex _mtx;
+    std::condition_variable _timersChanged;
+    // Due time to task, tasks due at the same time keep their order
+    std::multimap<Clock::time_point, std::function<void()>> _timers;
+    bool _stopping = false;
+    // After the timer state, so the tasks the pool still runs while it is
+    // destroyed can post timers, and before the timer thread which submits to it
+    ThreadPool _pool;
+    std::thread _timerThread;
+
+    void runTimers();
+
+    struct ScheduleAwaiter {
+        Executor& executor;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> suspended) {
+            this->executor.post([suspended]() {
+                suspended.resume();
+            });
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+    struct SleepAwaiter {
+        Executor& executor;
+        Clock::time_point until;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> suspended) {
+            this->executor.postAt(this->until, [suspended]() {
+                suspended.resume();
+            });
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+    static Detached run(Executor& executor, Task<void> task);
+
+public:
+    explicit Executor(std::size_t threads);
+    // Stops the timer thread, then runs what is already queued on the pool.
+    // Timers not yet due, or posted meanwhile, are dropped, so wait for
+    // outstanding coroutines before destroying it.
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    std::size_t size() const;
+    void post(std::function<void()> task);
+    // Posts task to the pool once at has passed
+    void postAt(Clock::time_point at, std::function<void()> task);
+
+    // co_await executor.schedule() continues the coroutine on the pool
+    ScheduleAwaiter schedule();
+    // co_await executor.sleepFor(d) continues it on the pool after d,
+    // without blocking a thread meanwhile
+    SleepAwaiter sleepFor(Clock::duration duration);
+    // Starts task on the pool without waiting for it. The task must not throw.
+    void spawn(Task<void> task);
+};
+
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace patterns::concurrency {
+
+template <typename T>
+class Task;
+
+// Parts of a Task promise that do not depend on the result type
+class TaskPromiseBase {
+private:
+    // Resumes whoever awaited the task once it finishes
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept {
+            const auto continuation = finished.promise()._continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+protected:
+    std::coroutine_handle<> _continuation;
+    std::exception_ptr _error;
+
+    void rethrowError() const {
+        if (this->_error) {
+            std::rethrow_exception(this->_error);
+        }
+    }
+
+public:
+    // Tasks are lazy, nothing runs until the task is awaited
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() noexcept {
+        this->_error = std::current_exception();
+    }
+
+    void setContinuation(std::coroutine_handle<> continuation) {
+        this->_continuation = continuation;
+    }
+};
+
+template <typename T>
+class TaskPromise final : public TaskPromiseBase {
+private:
+    std::optional<T> _value;
+
+public:
+    Task<T> get_return_object();
+
+    template <typename U>
+    void return_value(U&& value) {
+        this->_value.emplace(std::forward<U>(value));
+    }
+
+    T result() {
+        this->rethrowError();
+        return std::move(*this->_value);
+    }
+};
+
+template <>
+class TaskPromise<void> final : public TaskPromiseBase {
+public:
+    Task<void> get_return_object();
+
+    void return_void() const noexcept { }
+
+    void result() const {
+        this->rethrowError();
+    }
+};
+
+// Lazily started coroutine producing a T, or the exception it threw.
+// Awaiting a task starts it and resumes the awaiting coroutine, on whatever
+// thread the task finishes, once it is done.
+template <typename T>
+class Task final {
+public:
+    using promise_type = TaskPromise<T>;
+
+private:
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Handle _handle;
+
+public:
+    explicit Task(Handle handle) : _handle(handle) { }
+
+    // Movable
+    Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) { }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (this->_handle) {
+                this->_handle.destroy();
+            }
+            this->_handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+
+    // Not copyable
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (this->_handle) {
+            this->_handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return !this->_handle || this->_handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        this->_handle.promise().setContinuation(awaiting);
+        return this->_handle;
+    }
+
+    T await_resume() {
+        return this->_handle.promise().result();
+    }
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Coroutine nobody waits for. It starts right away and frees itself when it
+// is done, so it has to handle its own exceptions.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() const noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+
+        void return_void() const noexcept { }
+
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+};
+
+// Used by syncWait. Owns the promise, so the waiting thread can go as soon
+// as the result is set.
+template <typename T>
+Detached completeInto(Task<T> task, std::promise<T> result) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            result.set_value();
+        } else {
+            result.set_value(co_await task);
+        }
+    } catch (...) {
+        result.set_exception(std::current_exception());
+    }
+}
+
+// Runs task, blocking the calling thread until it is done
+template <typename T>
+T syncWait(Task<T> task) {
+    std::promise<T> result;
+    auto done = result.get_future();
+    completeInto(std::move(task), std::move(result));
+    return done.get();
+}
+
+}
@@ -0,0 +1,68 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace patterns::concurrency {
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    threads = std::max<std::size_t>(threads, 1);
+    for (std::size_t i = 0; i < threads; ++i) {
+        this->_workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->_mtx);
+        this->_stopping = true;
+    }
+    this->_taskReady.notify_all();
+    for (auto& worker : this->_workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const {
+    return this->_workers.size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(this->_mtx);
+        this->_tasks.push_back(std::move(task));
+    }
+    this->_taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(this->_mtx);
+    this->_idle.wait(lock, [this]() {
+        return this->_tasks.empty() && (this->_running == 0);
+    });
+}
+
+void ThreadPool::work() {
+    std::unique_lock<std::mutex> lock(this->_mtx);
+    while (true) {
+        this->_taskReady.wait(lock, [this]() {
+            return this->_stopping || !this->_tasks.empty();
+        });
+        if (this->_tasks.empty()) {
+            return;
+        }
+
+        auto task = std::move(this->_tasks.front());
+        this->_tasks.pop_front();
+        ++this->_running;
+        lock.unlock();
+        task();
+        lock.lock();
+        --this->_running;
+
+        if (this->_tasks.empty() && (this->_running == 0)) {
+            this->_idle.notify_all();
+        }
+    }
+}
+
+}
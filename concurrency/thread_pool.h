@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace patterns::concurrency {
+
+// Fixed set of worker threads running submitted tasks in FIFO order.
+// Tasks must not throw.
+class ThreadPool final {
+private:
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mtx;
+    std::condition_variable _taskReady;
+    std::condition_variable _idle;
+    std::size_t _running = 0;
+    bool _stopping = false;
+
+    void work();
+
+public:
+    explicit ThreadPool(std::size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const;
+    // Tasks may submit further tasks
+    void submit(std::function<void()> task);
+    // Blocks until the queue is empty and no task is running
+    void wait();
+};
+
+}
@@ -1,27 +1,120 @@
 #include "builder.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <utility>
 
 namespace patterns::creational {
 
+namespace {
+
+// Builders only ever add these, so they are interned once up front
+const MenuItemId shrimpCocktail = MenuItemTable::global().intern(BbqKitchen::appetizer);
+const MenuItemId bbqRibs = MenuItemTable::global().intern(BbqKitchen::entry);
+const MenuItemId iceCream = MenuItemTable::global().intern(BbqKitchen::desert);
+
+}
+
+MenuItemTable::MenuItemTable() : _views(new std::string_view[capacity]), _size(0) { }
+
+MenuItemTable& MenuItemTable::global() {
+    return *Singleton<MenuItemTable>::get();
+}
+
+MenuItemId MenuItemTable::intern(std::string_view name) {
+    std::lock_guard<std::mutex> lock(this->_mtx);
+    const auto found = this->_ids.find(name);
+    if (found != this->_ids.end()) {
+        return found->second;
+    }
+
+    const std::size_t id = this->_size.load(std::memory_order_relaxed);
+    if (id == capacity) {
+        throw std::runtime_error("menu item table is full");
+    }
+    auto storage = std::make_unique<std::string>();
+    storage->reserve(2 * name.size() + 2);
+    storage->append(name).append(1, ';').append(name).append(1, '\n');
+    this->_names.push_back(std::move(storage));
+    const std::string_view stored = std::string_view(*this->_names.back()).substr(0, name.size());
+    this->_ids.emplace(stored, static_cast<MenuItemId>(id));
+    this->_views[id] = stored;
+    // Publishes the view to name() on other threads
+    this->_size.store(id + 1, std::memory_order_release);
+    return static_cast<MenuItemId>(id);
+}
+
+std::string_view MenuItemTable::name(MenuItemId id) const {
+    if (id >= this->_size.load(std::memory_order_acquire)) {
+        throw std::runtime_error("unknown menu item " + std::to_string(id));
+    }
+    return this->_views[id];
+}
+
+std::string_view MenuItemTable::terminated(MenuItemId id, bool last) const {
+    const auto name = this->name(id);
+    return std::string_view(name.data() + (last ? name.size() + 1 : 0), name.size() + 1);
+}
+
+std::size_t MenuItemTable::size() const {
+    return this->_size.load(std::memory_order_acquire);
+}
+
 void DinnerMenu::add(const std::string& item) {
-    this->_menu.emplace_back(item);
+    this->add(MenuItemTable::global().intern(item));
+}
+
+void DinnerMenu::add(MenuItemId item) {
+    // Room for appetizer, entry and desert in the first allocation
+    if (this->_menu.capacity() == 0) {
+        this->_menu.reserve(4);
+    }
+    this->_menu.push_back(item);
+}
+
+void DinnerMenu::clear() {
+    this->_menu.clear();
+}
+
+const std::vector<MenuItemId>& DinnerMenu::items() const {
+    return this->_menu;
+}
+
+std::size_t DinnerMenu::menuSize() const {
+    if (this->_menu.empty()) {
+        return 0;
+    }
+    const auto& table = MenuItemTable::global();
+    std::size_t size = this->_menu.size() - 1;
+    for (const auto item : this->_menu) {
+        size += table.name(item).size();
+    }
+    return size;
 }
 
 std::string DinnerMenu::menu() const {
+    const auto& table = MenuItemTable::global();
     std::string meal;
-    for (const auto& item : this->_menu) {
-        meal += item;
-        meal += ";";
-    }
-    if (!meal.empty()) {
-        meal.pop_back();
+    meal.reserve(this->menuSize());
+    for (std::size_t i = 0; i < this->_menu.size(); ++i) {
+        if (i != 0) {
+            meal += ';';
+        }
+        meal += table.name(this->_menu[i]);
     }
     return meal;
 }
 
 void Builder::reset() {
-    this->_dinner = std::make_unique<DinnerMenu>();
+    if (this->_spare.empty()) {
+        this->_dinner = std::make_unique<DinnerMenu>();
+        return;
+    }
+    this->_dinner = std::move(this->_spare.back());
+    this->_spare.pop_back();
 }
 
 Builder::Builder() {
@@ -34,21 +127,33 @@ UniqueDinner Builder::getDinner() {
     return clone;
 }
 
+void Builder::getDinner(DinnerMenu& out) {
+    std::swap(*this->_dinner, out);
+    this->_dinner->clear();
+}
+
+void Builder::recycle(UniqueDinner dinner) {
+    if (dinner) {
+        dinner->clear();
+        this->_spare.push_back(std::move(dinner));
+    }
+}
+
 BbqDinnerBuilder::BbqDinnerBuilder() : Builder() { }
 
 void BbqDinnerBuilder::makeAppetizer() const {
-    this->_dinner->add("shrimp cocktail");
+    this->_dinner->add(shrimpCocktail);
 }
 
 void BbqDinnerBuilder::makeEntry() const {
-    this->_dinner->add("bbq ribs");
+    this->_dinner->add(bbqRibs);
 }
 
 void BbqDinnerBuilder::makeDesert() const {
-    this->_dinner->add("ice cream");
+    this->_dinner->add(iceCream);
 }
 
-DinnerDirector::DinnerDirector(BbqDinnerBuilder* builder) : _builder(builder) { }
+DinnerDirector::DinnerDirector(Builder* builder) : _builder(builder) { }
 
 void DinnerDirector::liteDinner() {
     this->_builder->makeEntry();   
@@ -60,4 +165,75 @@ void DinnerDirector::fullDinner() {
     this->_builder->makeDesert();
 }
 
-}
\ No newline at end of file
+BatchDinnerDirector::BatchDinnerDirector(concurrency::ThreadPool& pool, std::function<UniqueBuilder()> makeBuilder)
+    : _pool(pool), _makeBuilder(std::move(makeBuilder)) { }
+
+void BatchDinnerDirector::produce(std::size_t count, DinnerRecipe recipe, std::vector<DinnerMenu>& out) {
+    out.resize(count);
+
+    const std::size_t workers = this->_pool.size();
+    while (this->_builders.size() < workers) {
+        this->_builders.push_back(this->_makeBuilder());
+    }
+
+    // One contiguous slice per worker, so no two slices share a builder
+    const std::size_t slice = (count + workers - 1) / workers;
+    const std::size_t slices = (slice == 0) ? 0 : (count + slice - 1) / slice;
+    if (slices == 0) {
+        return;
+    }
+
+    // Slices are claimed from a shared index by the pool tasks and by the
+    // calling thread alike. The caller runs whatever no worker has picked up,
+    // so it only ever waits on slices already running, even when called from
+    // a pool task with every other worker busy. Tasks still queued after the
+    // batch is over find nothing to claim, they own the state for that reason.
+    // A throwing slice still counts as finished, so the caller always waits
+    // for every slice before it rethrows the first error.
+    struct Batch {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> finished{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+    };
+    auto batch = std::make_shared<Batch>();
+    auto run = [builders = this->_builders.data(), recipe, slice, slices, count, &out](Batch& state) {
+        for (auto claimed = state.next.fetch_add(1); claimed < slices; claimed = state.next.fetch_add(1)) {
+            Builder* builder = builders[claimed].get();
+            try {
+                DinnerDirector director(builder);
+                const std::size_t end = std::min(count, (claimed + 1) * slice);
+                for (std::size_t i = claimed * slice; i < end; ++i) {
+                    (director.*recipe)();
+                    builder->getDinner(out[i]);
+                }
+            } catch (...) {
+                // Drops the half built dinner so the builder starts clean next time
+                DinnerMenu partial;
+                builder->getDinner(partial);
+                if (!state.failed.exchange(true)) {
+                    state.error = std::current_exception();
+                }
+            }
+            if (state.finished.fetch_add(1) + 1 == slices) {
+                state.finished.notify_all();
+            }
+        }
+    };
+
+    for (std::size_t helper = 1; helper < slices; ++helper) {
+        this->_pool.submit([batch, run]() {
+            run(*batch);
+        });
+    }
+    run(*batch);
+
+    for (auto finished = batch->finished.load(); finished != slices; finished = batch->finished.load()) {
+        batch->finished.wait(finished);
+    }
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+}
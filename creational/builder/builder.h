@@ -1,19 +1,70 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "../../concurrency/thread_pool.h"
+#include "../singleton/singleton.h"
+#include "static_builder.h"
+
 namespace patterns::creational {
 
+using MenuItemId = std::uint16_t;
+
+// Process wide table of distinct menu item names. Every name is stored once
+// and menus refer to it by id. Interning takes a lock, looking a name up by
+// id does not.
+class MenuItemTable final {
+private:
+    friend class Singleton<MenuItemTable>;
+
+    static constexpr std::size_t capacity = 4096;
+
+    std::mutex _mtx;
+    // Names are never removed, so the views stay valid. Each one is stored as
+    // "name;name\n", the views cover the first name.
+    std::vector<std::unique_ptr<std::string>> _names;
+    std::unordered_map<std::string_view, MenuItemId> _ids;
+    std::unique_ptr<std::string_view[]> _views;
+    std::atomic<std::size_t> _size;
+
+    MenuItemTable();
+
+public:
+    static MenuItemTable& global();
+
+    // Id of name, adding it on first use
+    MenuItemId intern(std::string_view name);
+    std::string_view name(MenuItemId id) const;
+    // Name followed by ';', or by '\n' for the last item of a menu line,
+    // stored contiguously so exporters can gather lines without copying
+    std::string_view terminated(MenuItemId id, bool last) const;
+    std::size_t size() const;
+};
+
 // Product
 class DinnerMenu {
 private:
-    std::vector<std::string> _menu;
+    std::vector<MenuItemId> _menu;
 
 public:
     DinnerMenu() = default;
     void add(const std::string& item);
+    // Empties the menu but keeps its storage
+    void clear();
+    void add(MenuItemId item);
+    const std::vector<MenuItemId>& items() const;
+    // Exact length of menu()
+    std::size_t menuSize() const;
+    // Items joined with ';', built in a single allocation
     std::string menu() const;
 };
 
@@ -22,6 +73,9 @@ using UniqueDinner = std::unique_ptr<DinnerMenu>;
 // Builder interface
 class Builder {
 private:
+    // Dinners handed back through recycle, reused before allocating new ones
+    std::vector<UniqueDinner> _spare;
+
     void reset();
 protected:
     Builder();
@@ -33,9 +87,16 @@ public:
     virtual void makeEntry() const = 0;
     virtual void makeDesert() const = 0;
     UniqueDinner getDinner();
+    // Swaps the product into out. The builder keeps the storage out had,
+    // so a caller reusing out never allocates a new product.
+    void getDinner(DinnerMenu& out);
+    // Takes back a dinner from getDinner() as storage for a later product
+    void recycle(UniqueDinner dinner);
 };
 
-// Concete builder
+using UniqueBuilder = std::unique_ptr<Builder>;
+
+// Concete builder, cooks what BbqKitchen lists
 class BbqDinnerBuilder : public Builder {
 public:
     BbqDinnerBuilder();
@@ -51,10 +112,33 @@ private:
     Builder* _builder = nullptr;
 
 public:
-    DinnerDirector(BbqDinnerBuilder* builder);
+    DinnerDirector(Builder* builder);
 
     void liteDinner();
     void fullDinner();
 };
 
+// One of the DinnerDirector steps, e.g. &DinnerDirector::fullDinner
+using DinnerRecipe = void (DinnerDirector::*)();
+
+// Director for many dinners at once. Splits a batch over the pool with one
+// builder per worker, created on first use and reused for later batches.
+// The calling thread works on the batch too, so produce() may be called from
+// a pool task. One batch at a time per director.
+class BatchDinnerDirector {
+private:
+    concurrency::ThreadPool& _pool;
+    std::function<UniqueBuilder()> _makeBuilder;
+    std::vector<UniqueBuilder> _builders;
+
+public:
+    BatchDinnerDirector(concurrency::ThreadPool& pool, std::function<UniqueBuilder()> makeBuilder);
+
+    // Fills out with count dinners made by recipe. Dinners already in out
+    // are recycled, so repeated batches of the same size do not allocate.
+    // When a recipe throws, the first exception is rethrown once every slice
+    // is done, and out is left with some dinners not made.
+    void produce(std::size_t count, DinnerRecipe recipe, std::vector<DinnerMenu>& out);
+};
+
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "menu_exporter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace patterns::creational {
+
+namespace {
+
+constexpr char newline = '\n';
+
+}
+
+MenuExporter::MenuExporter(int fd, std::size_t copyThreshold)
+    : _fd(fd), _copyThreshold(std::min(copyThreshold, stagingSize)), _staging(new char[stagingSize]) { }
+
+MenuExporter::~MenuExporter() {
+    try {
+        this->flush();
+    } catch (const std::runtime_error&) {
+    }
+}
+
+void MenuExporter::push(std::string_view piece) {
+    const char* data = piece.data();
+    const std::size_t size = piece.size();
+    if (size < this->_copyThreshold) {
+        // A staged piece may still need a buffer of its own, so both limits count
+        if (((this->_staged + size) > stagingSize) || (this->_count == batch)) {
+            this->flush();
+        }
+        char* staged = this->_staging.get() + this->_staged;
+        std::memcpy(staged, data, size);
+        this->_staged += size;
+
+        // Grows the last buffer when it already ends where this piece starts
+        if (this->_count != 0) {
+            iovec& last = this->_buffers[this->_count - 1];
+            if ((static_cast<char*>(last.iov_base) + last.iov_len) == staged) {
+                last.iov_len += size;
+                return;
+            }
+        }
+        data = staged;
+    } else if (this->_count == batch) {
+        this->flush();
+    }
+
+    // writev only reads through iov_base
+    this->_buffers[this->_count].iov_base = const_cast<char*>(data);
+    this->_buffers[this->_count].iov_len = size;
+    ++this->_count;
+}
+
+void MenuExporter::write(const DinnerMenu& dinner) {
+    const auto& table = MenuItemTable::global();
+    const auto& items = dinner.items();
+    if (items.empty()) {
+        this->push(std::string_view(&newline, 1));
+        return;
+    }
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        this->push(table.terminated(items[i], i + 1 == items.size()));
+    }
+}
+
+void MenuExporter::flush() {
+    iovec* next = this->_buffers.data();
+    std::size_t left = this->_count;
+    this->_count = 0;
+    this->_staged = 0;
+    while (left != 0) {
+        const ssize_t written = ::writev(this->_fd, next, static_cast<int>(left));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("cannot export menus: ") + std::strerror(errno));
+        }
+
+        // Skips the buffers written in full and trims a partially written one
+        auto remaining = static_cast<std::size_t>(written);
+        while ((left != 0) && (remaining >= next->iov_len)) {
+            remaining -= next->iov_len;
+            ++next;
+            --left;
+        }
+        if (left != 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + remaining;
+            next->iov_len -= remaining;
+        }
+    }
+}
+
+}
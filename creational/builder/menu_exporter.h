@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+#include <sys/uio.h>
+
+#include "builder.h"
+
+namespace patterns::creational {
+
+// Streams menus to a file descriptor, one per line, without building a menu
+// string per dinner. The interned table stores every name already followed
+// by its separator or newline, so each item is one piece. Pieces of at least
+// copyThreshold bytes are gathered with writev straight from the table.
+// The kernel pays per buffer, so shorter ones are copied into one fixed
+// staging buffer and sent as a single iovec instead.
+class MenuExporter final {
+public:
+    // Where gathering starts to beat copying on the menu_export benchmark
+    static constexpr std::size_t defaultCopyThreshold = 256;
+
+private:
+    // IOV_MAX on Linux
+    static constexpr std::size_t batch = 1024;
+    static constexpr std::size_t stagingSize = 64 * 1024;
+
+    int _fd;
+    std::size_t _copyThreshold;
+    std::array<iovec, batch> _buffers;
+    std::size_t _count = 0;
+    std::unique_ptr<char[]> _staging;
+    std::size_t _staged = 0;
+
+    void push(std::string_view piece);
+
+public:
+    // Does not take ownership of fd. A threshold of 0 gathers every piece.
+    explicit MenuExporter(int fd, std::size_t copyThreshold = defaultCopyThreshold);
+    // Flushes what is left, ignoring errors. Call flush() to see them.
+    ~MenuExporter();
+
+    MenuExporter(const MenuExporter&) = delete;
+    MenuExporter& operator=(const MenuExporter&) = delete;
+
+    // Same text as menu() followed by a newline
+    void write(const DinnerMenu& dinner);
+    // Throws when the descriptor refuses the data
+    void flush();
+};
+
+}
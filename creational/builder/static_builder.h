@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace patterns::creational {
+
+// Items cooked by BbqDinnerBuilder, shared with its compile time counterpart
+struct BbqKitchen {
+    static constexpr std::string_view appetizer = "shrimp cocktail";
+    static constexpr std::string_view entry = "bbq ribs";
+    static constexpr std::string_view desert = "ice cream";
+};
+
+// Courses of a compile time recipe, each picks its item from a kitchen
+struct Appetizer {
+    template <typename Kitchen>
+    static constexpr std::string_view item() {
+        return Kitchen::appetizer;
+    }
+};
+
+struct Entry {
+    template <typename Kitchen>
+    static constexpr std::string_view item() {
+        return Kitchen::entry;
+    }
+};
+
+struct Desert {
+    template <typename Kitchen>
+    static constexpr std::string_view item() {
+        return Kitchen::desert;
+    }
+};
+
+// Length of the courses joined with ';'
+template <typename Kitchen, typename... Courses>
+constexpr std::size_t staticMenuSize() {
+    std::size_t size = 0;
+    ((size += Courses::template item<Kitchen>().size() + 1), ...);
+    return (size == 0) ? 0 : size - 1;
+}
+
+// The courses joined with ';' and null terminated, the same text DinnerMenu::menu() gives
+template <typename Kitchen, typename... Courses>
+constexpr std::array<char, staticMenuSize<Kitchen, Courses...>() + 1> composeMenu() {
+    std::array<char, staticMenuSize<Kitchen, Courses...>() + 1> text{};
+    std::size_t pos = 0;
+    bool first = true;
+    [[maybe_unused]] auto append = [&text, &pos, &first](std::string_view item) {
+        if (!first) {
+            text[pos++] = ';';
+        }
+        first = false;
+        for (const char c : item) {
+            text[pos++] = c;
+        }
+    };
+    (append(Courses::template item<Kitchen>()), ...);
+    return text;
+}
+
+// Builder for a recipe fixed at compile time. The menu is composed by the
+// compiler and lives in read only data, so menu() costs nothing at runtime.
+template <typename Kitchen, typename... Courses>
+class StaticDinner final {
+private:
+    static constexpr auto _text = composeMenu<Kitchen, Courses...>();
+
+public:
+    static constexpr std::string_view menu() {
+        return std::string_view(_text.data(), _text.size() - 1);
+    }
+};
+
+// Same recipes as DinnerDirector::liteDinner and DinnerDirector::fullDinner
+template <typename Kitchen>
+using StaticLiteDinner = StaticDinner<Kitchen, Entry>;
+
+template <typename Kitchen>
+using StaticFullDinner = StaticDinner<Kitchen, Appetizer, Entry, Desert>;
+
+}
@@ -1,7 +1,16 @@
 #include "factorymethod.h"
 
+#include "shape_registry.h"
+
 namespace patterns::creational {
 
+namespace {
+
+const ShapeRegistrar<Triangle> triangleRegistrar("triangle");
+const ShapeRegistrar<Rectangle> rectangleRegistrar("rectangle");
+
+}
+
 std::string Triangle::draw() const {
     return "triangle";
 }
@@ -0,0 +1,209 @@
+#include "shape_registry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "../singleton/singleton.h"
+
+namespace patterns::creational {
+
+namespace {
+
+constexpr std::uint32_t maxSeed = 1u << 16;
+constexpr std::uint32_t maxGlobalSeeds = 64;
+
+// Murmur3 finalizer, every input bit reaches the high bits that pick the slot
+std::uint64_t mix64(std::uint64_t h) {
+    h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdull;
+    h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33);
+}
+
+std::uint64_t seedMix(std::uint64_t seed) {
+    return mix64(seed * 0x9e3779b97f4a7c15ull + 0x632be59bd9b4e019ull);
+}
+
+std::uint64_t nextPowerOfTwo(std::uint64_t n) {
+    std::uint64_t power = 1;
+    while (power < n) {
+        power <<= 1;
+    }
+    return power;
+}
+
+}
+
+constexpr std::uint32_t ShapeRegistry::emptySlot;
+
+ShapeRegistry& ShapeRegistry::global() {
+    return *Singleton<ShapeRegistry>::get();
+}
+
+// Word at a time multiply-xorshift, keys are short names so this mostly
+// runs a single iteration
+std::uint64_t ShapeRegistry::hash(const char* key, std::size_t size, std::uint64_t seed) {
+    constexpr std::uint64_t multiplier = 0x9fb21c651e98df25ull;
+    std::uint64_t h = (size ^ seed) * multiplier;
+    while (size >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, key, 8);
+        h = (h ^ word) * multiplier;
+        h ^= h >> 29;
+        key += 8;
+        size -= 8;
+    }
+    // The tail is read with two overlapping loads rather than copied byte by
+    // byte, a partial copy makes the word load stall on store forwarding
+    if (size >= 4) {
+        std::uint32_t low;
+        std::uint32_t high;
+        std::memcpy(&low, key, 4);
+        std::memcpy(&high, key + size - 4, 4);
+        h = (h ^ (low | (static_cast<std::uint64_t>(high) << 32))) * multiplier;
+        h ^= h >> 29;
+    } else if (size > 0) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(key);
+        const std::uint64_t word = (std::uint64_t{bytes[0]} << 16) |
+            (std::uint64_t{bytes[size / 2]} << 8) | bytes[size - 1];
+        h = (h ^ word) * multiplier;
+        h ^= h >> 29;
+    }
+    // Avalanche so the low bits used for buckets depend on every byte
+    return mix64(h);
+}
+
+// Full finalizer over the key hash and the mixed bucket seed, so each seed
+// gives a bucket an independent placement. The high bits pick the slot.
+std::uint64_t ShapeRegistry::slotIndex(std::uint64_t keyHash, std::uint64_t seedMix) const {
+    return mix64(keyHash ^ seedMix) >> this->_slotShift;
+}
+
+void ShapeRegistry::add(std::string name, Creator creator) {
+    if (this->_frozen) {
+        throw std::runtime_error("shape registry is frozen, cannot add " + name);
+    }
+    if (this->_index.find(name) != this->_index.end()) {
+        throw std::runtime_error("shape registered twice: " + name);
+    }
+    this->_index.emplace(name, this->_entries.size());
+    this->_entries.push_back({std::move(name), creator});
+}
+
+// Hash and displace: fill the biggest buckets first, searching for each one
+// a seed that sends all of its keys to distinct free slots. A bucket no seed
+// fits starts over with another global seed.
+void ShapeRegistry::freeze() {
+    if (this->_frozen) {
+        return;
+    }
+
+    for (std::uint32_t globalSeed = 0; globalSeed < maxGlobalSeeds; ++globalSeed) {
+        if (this->tryFreeze(seedMix(globalSeed))) {
+            this->_frozen = true;
+            return;
+        }
+    }
+    throw std::runtime_error("shape registry: no perfect hash for " + std::to_string(this->_entries.size()) + " shapes");
+}
+
+bool ShapeRegistry::tryFreeze(std::uint64_t globalSeed) {
+    const std::uint64_t keys = std::max<std::uint64_t>(this->_entries.size(), 1);
+    const std::uint64_t bucketCount = nextPowerOfTwo((keys + 1) / 2);
+    const std::uint64_t slotCount = nextPowerOfTwo(2 * keys);
+    this->_globalSeed = globalSeed;
+    this->_bucketMask = bucketCount - 1;
+    this->_slotShift = 64;
+    for (std::uint64_t n = slotCount; n > 1; n >>= 1) {
+        --this->_slotShift;
+    }
+
+    std::vector<std::uint64_t> hashes(this->_entries.size());
+    std::vector<std::vector<std::uint32_t>> buckets(bucketCount);
+    for (std::size_t i = 0; i < this->_entries.size(); ++i) {
+        const auto& name = this->_entries[i].name;
+        hashes[i] = ShapeRegistry::hash(name.data(), name.size(), globalSeed);
+        buckets[hashes[i] & this->_bucketMask].push_back(static_cast<std::uint32_t>(i));
+    }
+
+    std::vector<std::uint32_t> order(bucketCount);
+    for (std::uint32_t b = 0; b < bucketCount; ++b) {
+        order[b] = b;
+    }
+    std::sort(order.begin(), order.end(), [&buckets](std::uint32_t a, std::uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    this->_seeds.assign(bucketCount, seedMix(0));
+    this->_slots.assign(slotCount, Slot{0, nullptr, emptySlot});
+    std::vector<std::uint64_t> taken;
+    for (auto b : order) {
+        const auto& bucket = buckets[b];
+        if (bucket.empty()) {
+            break;
+        }
+
+        std::uint32_t seed = 0;
+        std::uint64_t mixed = 0;
+        for (; seed < maxSeed; ++seed) {
+            mixed = seedMix(seed);
+            taken.clear();
+            bool fits = true;
+            for (auto entry : bucket) {
+                const auto slot = this->slotIndex(hashes[entry], mixed);
+                if ((this->_slots[slot].entry != emptySlot) ||
+                    (std::find(taken.begin(), taken.end(), slot) != taken.end())) {
+                    fits = false;
+                    break;
+                }
+                taken.push_back(slot);
+            }
+            if (fits) {
+                break;
+            }
+        }
+        if (seed == maxSeed) {
+            return false;
+        }
+
+        this->_seeds[b] = mixed;
+        for (std::size_t i = 0; i < bucket.size(); ++i) {
+            const auto entry = bucket[i];
+            this->_slots[taken[i]] = Slot{hashes[entry], this->_entries[entry].creator, entry};
+        }
+    }
+    return true;
+}
+
+bool ShapeRegistry::frozen() const {
+    return this->_frozen;
+}
+
+std::size_t ShapeRegistry::size() const {
+    return this->_entries.size();
+}
+
+ShapeRegistry::Creator ShapeRegistry::find(const std::string& name) const {
+    if (!this->_frozen) {
+        auto it = this->_index.find(name);
+        return (it != this->_index.end()) ? this->_entries[it->second].creator : nullptr;
+    }
+
+    const auto keyHash = ShapeRegistry::hash(name.data(), name.size(), this->_globalSeed);
+    const auto seed = this->_seeds[keyHash & this->_bucketMask];
+    const auto& slot = this->_slots[this->slotIndex(keyHash, seed)];
+    if ((slot.hash != keyHash) || (slot.entry == emptySlot) || (this->_entries[slot.entry].name != name)) {
+        return nullptr;
+    }
+    return slot.creator;
+}
+
+UniqueShape ShapeRegistry::create(const std::string& name) const {
+    auto creator = this->find(name);
+    if (creator == nullptr) {
+        throw std::runtime_error("unknown shape: " + name);
+    }
+    return creator();
+}
+
+}
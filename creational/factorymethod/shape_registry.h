@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "factorymethod.h"
+
+namespace patterns::creational {
+
+// Creates shapes by name, for types only known from config or the wire.
+// Shapes self-register through a static ShapeRegistrar. Once all of them are
+// in, freeze() builds a perfect hash over the names so a lookup costs one
+// hash of the key and a single string compare.
+class ShapeRegistry final {
+public:
+    using Creator = UniqueShape (*)();
+
+private:
+    struct Entry {
+        std::string name;
+        Creator creator;
+    };
+
+    // Keeps the key hash next to the entry so a miss is rejected without
+    // touching the name, and a hit reads the creator from the slot
+    struct Slot {
+        std::uint64_t hash;
+        Creator creator;
+        std::uint32_t entry;
+    };
+
+    static constexpr std::uint32_t emptySlot = UINT32_MAX;
+
+    std::vector<Entry> _entries;
+    std::unordered_map<std::string, std::size_t> _index;
+
+    // Perfect hash: the key hash picks a bucket, the bucket seed picks the slot.
+    // The global seed goes into every key hash, freeze() picks another one
+    // when some bucket finds no seed.
+    bool _frozen = false;
+    std::uint64_t _globalSeed = 0;
+    std::uint64_t _bucketMask = 0;
+    unsigned _slotShift = 0;
+    // Bucket seeds are stored already mixed
+    std::vector<std::uint64_t> _seeds;
+    std::vector<Slot> _slots;
+
+    static std::uint64_t hash(const char* key, std::size_t size, std::uint64_t seed);
+    std::uint64_t slotIndex(std::uint64_t keyHash, std::uint64_t seedMix) const;
+    bool tryFreeze(std::uint64_t globalSeed);
+
+public:
+    ShapeRegistry() = default;
+    ~ShapeRegistry() = default;
+
+    // Process wide registry the ShapeRegistrar objects add themselves to
+    static ShapeRegistry& global();
+
+    // Throws when the name is taken or the registry is frozen
+    void add(std::string name, Creator creator);
+    void freeze();
+    bool frozen() const;
+    std::size_t size() const;
+
+    // nullptr for unknown names
+    Creator find(const std::string& name) const;
+    // Throws for unknown names
+    UniqueShape create(const std::string& name) const;
+};
+
+// Registers T under the given name when constructed, meant for namespace scope statics
+template <typename T>
+class ShapeRegistrar final {
+public:
+    explicit ShapeRegistrar(std::string name) {
+        ShapeRegistry::global().add(std::move(name), []() -> UniqueShape {
+            return std::make_unique<T>();
+        });
+    }
+};
+
+}
@@ -0,0 +1,75 @@
+#include "shape_variant.h"
+
+#include <cstring>
+
+namespace patterns::creational {
+
+namespace {
+
+constexpr std::string_view prefix = "name: ";
+constexpr std::string_view separator = "; ";
+
+// Indexed by ShapeVariant::index(), so a batch draw is a table read
+// instead of a visit per element
+constexpr std::string_view names[] = {TriangleValue::name, RectangleValue::name};
+
+static_assert(std::size(names) == std::variant_size_v<ShapeVariant>, "every shape needs a name");
+
+}
+
+std::string_view drawView(const ShapeVariant& shape) {
+    return names[shape.index()];
+}
+
+std::string draw(const ShapeVariant& shape) {
+    return std::string(drawView(shape));
+}
+
+void ShapeBatch::reserve(std::size_t count) {
+    this->_shapes.reserve(count);
+}
+
+void ShapeBatch::add(ShapeVariant shape) {
+    this->_shapes.push_back(shape);
+}
+
+void ShapeBatch::clear() {
+    this->_shapes.clear();
+}
+
+std::size_t ShapeBatch::size() const {
+    return this->_shapes.size();
+}
+
+const ShapeVariant& ShapeBatch::operator[](std::size_t i) const {
+    return this->_shapes[i];
+}
+
+std::size_t ShapeBatch::drawnSize() const {
+    std::size_t size = this->_shapes.size() * (prefix.size() + separator.size());
+    for (const auto& shape : this->_shapes) {
+        size += names[shape.index()].size();
+    }
+    return size;
+}
+
+char* ShapeBatch::drawInto(char* out) const {
+    for (const auto& shape : this->_shapes) {
+        const auto name = names[shape.index()];
+        std::memcpy(out, prefix.data(), prefix.size());
+        out += prefix.size();
+        std::memcpy(out, name.data(), name.size());
+        out += name.size();
+        std::memcpy(out, separator.data(), separator.size());
+        out += separator.size();
+    }
+    return out;
+}
+
+void ShapeBatch::drawInto(std::string& out) const {
+    const auto offset = out.size();
+    out.resize(offset + this->drawnSize());
+    this->drawInto(out.data() + offset);
+}
+
+}
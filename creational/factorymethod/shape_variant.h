@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace patterns::creational {
+
+// Value counterparts of Triangle and Rectangle for the closed set of shapes.
+// They draw the same text without a heap object or a virtual call.
+struct TriangleValue {
+    static constexpr std::string_view name = "triangle";
+};
+
+struct RectangleValue {
+    static constexpr std::string_view name = "rectangle";
+};
+
+using ShapeVariant = std::variant<TriangleValue, RectangleValue>;
+
+// Same text as Shape::draw()
+std::string_view drawView(const ShapeVariant& shape);
+std::string draw(const ShapeVariant& shape);
+
+// Shapes stored contiguously by value. Draws the whole batch in one pass,
+// producing the same text as concatenating "<doWork()>; " for every shape.
+class ShapeBatch final {
+private:
+    std::vector<ShapeVariant> _shapes;
+
+public:
+    ShapeBatch() = default;
+    ~ShapeBatch() = default;
+
+    void reserve(std::size_t count);
+    void add(ShapeVariant shape);
+    void clear();
+    std::size_t size() const;
+    const ShapeVariant& operator[](std::size_t i) const;
+
+    // Exact number of characters drawInto writes
+    std::size_t drawnSize() const;
+    // Writes into a buffer of at least drawnSize() characters, returns the end
+    char* drawInto(char* out) const;
+    // Appends to out with a single reallocation at most
+    void drawInto(std::string& out) const;
+};
+
+}
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../pointers/unique/custom_unique_ptr.h"
+
+namespace patterns::creational {
+
+// Recycles storage for short lived objects instead of going through the
+// global allocator on every create/destroy.
+//
+// Free slots live in a per thread cache first, so a thread that keeps
+// acquiring and releasing objects touches no shared state but its own cache.
+// Caches exchange slots in batches with a shared lock-free stack. The pool
+// never holds more than `capacity` slots. Once all of them are allocated and
+// the shared stack is empty, acquire() takes back the slots parked in other
+// threads' caches, and returns an empty handle only when all are in use.
+//
+// Handles must be released before the pool is destroyed.
+template <typename T>
+class ObjectPool final {
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        ObjectPool* owner;
+        std::atomic<Slot*> next;
+    };
+
+    // Free slots a thread keeps for one pool, owned by the pool. Only the
+    // owning thread adds or removes single slots. Other threads may only
+    // take the whole list at once, so the owner's pop sees no ABA.
+    struct LocalCache {
+        std::atomic<Slot*> head{nullptr};
+        // Owner only, can overcount after the list was taken away
+        std::size_t count = 0;
+    };
+
+    struct CacheRef {
+        std::uint64_t poolId;
+        ObjectPool* pool;
+        LocalCache* cache;
+    };
+
+    // Caches of the current thread, handed back to their pools on thread exit
+    struct ThreadCaches {
+        std::vector<CacheRef> caches;
+        std::size_t last = 0;
+
+        ~ThreadCaches() {
+            std::lock_guard<std::mutex> lock(ObjectPool::livePoolsMtx());
+            for (auto& ref : this->caches) {
+                if (ObjectPool::livePools().count(ref.poolId) != 0) {
+                    ref.pool->retire(ref.cache);
+                }
+            }
+        }
+    };
+
+    static constexpr std::size_t cacheBatch = 32;
+    static constexpr std::size_t growBatch = 64;
+
+    // Tagged stack top: slot pointer in the low 48 bits, ABA tag above
+    using Word = std::uintptr_t;
+    static constexpr int pointerBits = 48;
+    static constexpr Word pointerMask = (Word(1) << pointerBits) - 1;
+
+    static_assert(sizeof(Word) == 8, "tagged stack needs 64 bit pointers");
+
+    const std::uint64_t _id;
+    const std::size_t _capacity;
+    std::atomic<Word> _free;
+    std::atomic<std::size_t> _allocated;
+    std::mutex _growMtx;
+    std::vector<std::unique_ptr<Slot[]>> _chunks;
+    std::mutex _cachesMtx;
+    std::vector<std::unique_ptr<LocalCache>> _caches;
+
+    static std::mutex& livePoolsMtx() {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    static std::unordered_map<std::uint64_t, ObjectPool*>& livePools() {
+        static std::unordered_map<std::uint64_t, ObjectPool*> pools;
+        return pools;
+    }
+
+    static std::uint64_t nextId() {
+        static std::atomic<std::uint64_t> ids(0);
+        return ids.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    static ThreadCaches& threadCaches() {
+        static thread_local ThreadCaches caches;
+        return caches;
+    }
+
+    static Slot* slotOf(Word w) {
+        return reinterpret_cast<Slot*>(w & pointerMask);
+    }
+
+    static Word pack(Slot* slot, Word tagged) {
+        const Word w = reinterpret_cast<Word>(slot);
+        assert((w & ~pointerMask) == 0);
+        return w | ((tagged & ~pointerMask) + (Word(1) << pointerBits));
+    }
+
+    void pushChain(Slot* first, Slot* last) {
+        Word top = this->_free.load(std::memory_order_relaxed);
+        Word next;
+        do {
+            last->next.store(slotOf(top), std::memory_order_relaxed);
+            next = pack(first, top);
+        } while (!this->_free.compare_exchange_weak(top, next,
+                    std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    Slot* pop() {
+        Word top = this->_free.load(std::memory_order_acquire);
+        while (slotOf(top) != nullptr) {
+            Slot* slot = slotOf(top);
+            const Word next = pack(slot->next.load(std::memory_order_relaxed), top);
+            if (this->_free.compare_exchange_weak(top, next,
+                    std::memory_order_acquire, std::memory_order_acquire)) {
+                return slot;
+            }
+        }
+        return nullptr;
+    }
+
+    // Adds up to `count` new slots to the shared stack, within capacity
+    bool grow(std::size_t count) {
+        std::lock_guard<std::mutex> lock(this->_growMtx);
+        const std::size_t allocated = this->_allocated.load(std::memory_order_relaxed);
+        count = std::min(count, this->_capacity - allocated);
+        if (count == 0) {
+            return false;
+        }
+
+        std::unique_ptr<Slot[]> chunk(new Slot[count]);
+        for (std::size_t i = 0; i < count; ++i) {
+            chunk[i].owner = this;
+            chunk[i].next.store((i + 1 < count) ? &chunk[i + 1] : nullptr, std::memory_order_relaxed);
+        }
+        this->pushChain(&chunk[0], &chunk[count - 1]);
+        this->_chunks.push_back(std::move(chunk));
+        this->_allocated.store(allocated + count, std::memory_order_relaxed);
+        return true;
+    }
+
+    LocalCache& localCache() {
+        auto& local = threadCaches();
+        if ((local.last < local.caches.size()) && (local.caches[local.last].poolId == this->_id)) {
+            return *local.caches[local.last].cache;
+        }
+        for (std::size_t i = 0; i < local.caches.size(); ++i) {
+            if (local.caches[i].poolId == this->_id) {
+                local.last = i;
+                return *local.caches[i].cache;
+            }
+        }
+
+        // First use on this thread, drop caches of pools that are gone meanwhile
+        {
+            std::lock_guard<std::mutex> lock(livePoolsMtx());
+            auto& pools = livePools();
+            local.caches.erase(std::remove_if(local.caches.begin(), local.caches.end(),
+                [&pools](const CacheRef& ref) { return pools.count(ref.poolId) == 0; }),
+                local.caches.end());
+        }
+        LocalCache* cache = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(this->_cachesMtx);
+            this->_caches.push_back(std::make_unique<LocalCache>());
+            cache = this->_caches.back().get();
+        }
+        local.caches.push_back({this->_id, this, cache});
+        local.last = local.caches.size() - 1;
+        return *cache;
+    }
+
+    static Slot* tailOf(Slot* first) {
+        Slot* last = first;
+        for (Slot* next = last->next.load(std::memory_order_relaxed); next != nullptr;
+                next = last->next.load(std::memory_order_relaxed)) {
+            last = next;
+        }
+        return last;
+    }
+
+    // Owner side of the cache, the list may be taken away in between
+    static void pushLocal(LocalCache& cache, Slot* first, Slot* last, std::size_t count) {
+        Slot* head = cache.head.load(std::memory_order_relaxed);
+        do {
+            last->next.store(head, std::memory_order_relaxed);
+        } while (!cache.head.compare_exchange_weak(head, first,
+                    std::memory_order_release, std::memory_order_relaxed));
+        cache.count = (head == nullptr) ? count : cache.count + count;
+    }
+
+    static Slot* popLocal(LocalCache& cache) {
+        Slot* head = cache.head.load(std::memory_order_acquire);
+        while (head != nullptr) {
+            if (cache.head.compare_exchange_weak(head, head->next.load(std::memory_order_relaxed),
+                    std::memory_order_acquire, std::memory_order_acquire)) {
+                cache.count = (cache.count > 0) ? cache.count - 1 : 0;
+                return head;
+            }
+        }
+        cache.count = 0;
+        return nullptr;
+    }
+
+    // Moves `count` slots from the cache to the shared stack
+    void flush(LocalCache& cache, std::size_t count) {
+        Slot* first = cache.head.exchange(nullptr, std::memory_order_acquire);
+        cache.count = 0;
+        if (first == nullptr) {
+            return;
+        }
+        Slot* last = first;
+        for (std::size_t i = 1; (i < count) && (last->next.load(std::memory_order_relaxed) != nullptr); ++i) {
+            last = last->next.load(std::memory_order_relaxed);
+        }
+        Slot* kept = last->next.load(std::memory_order_relaxed);
+        this->pushChain(first, last);
+
+        if (kept != nullptr) {
+            std::size_t keptCount = 1;
+            Slot* keptLast = kept;
+            for (Slot* next = kept->next.load(std::memory_order_relaxed); next != nullptr;
+                    next = keptLast->next.load(std::memory_order_relaxed)) {
+                keptLast = next;
+                ++keptCount;
+            }
+            pushLocal(cache, kept, keptLast, keptCount);
+        }
+    }
+
+    // Takes the slots parked in every thread's cache back to the shared stack.
+    // Only runs once the pool is fully allocated and the shared stack is empty.
+    void reclaim() {
+        std::lock_guard<std::mutex> lock(this->_cachesMtx);
+        for (auto& cache : this->_caches) {
+            Slot* first = cache->head.exchange(nullptr, std::memory_order_acquire);
+            if (first != nullptr) {
+                this->pushChain(first, tailOf(first));
+            }
+        }
+    }
+
+    // Hands a cache back when its thread exits
+    void retire(LocalCache* cache) {
+        std::lock_guard<std::mutex> lock(this->_cachesMtx);
+        Slot* first = cache->head.exchange(nullptr, std::memory_order_acquire);
+        if (first != nullptr) {
+            this->pushChain(first, tailOf(first));
+        }
+        this->_caches.erase(std::find_if(this->_caches.begin(), this->_caches.end(),
+            [cache](const std::unique_ptr<LocalCache>& owned) { return owned.get() == cache; }));
+    }
+
+    Slot* take() {
+        LocalCache& cache = this->localCache();
+        Slot* slot = popLocal(cache);
+        if (slot != nullptr) {
+            return slot;
+        }
+
+        // Refill a batch so the next acquisitions stay thread local
+        Slot* first = nullptr;
+        Slot* last = nullptr;
+        std::size_t count = 0;
+        while (count + 1 < cacheBatch) {
+            Slot* next = this->pop();
+            if ((next == nullptr) && (!this->grow(growBatch) || ((next = this->pop()) == nullptr))) {
+                break;
+            }
+            if (slot == nullptr) {
+                slot = next;
+                continue;
+            }
+            next->next.store(first, std::memory_order_relaxed);
+            first = next;
+            last = (last == nullptr) ? next : last;
+            ++count;
+        }
+        if (first != nullptr) {
+            pushLocal(cache, first, last, count);
+        }
+        if (slot == nullptr) {
+            this->reclaim();
+            slot = this->pop();
+        }
+        return slot;
+    }
+
+    void give(Slot* slot) {
+        LocalCache& cache = this->localCache();
+        pushLocal(cache, slot, slot, 1);
+        if (cache.count >= 2 * cacheBatch) {
+            this->flush(cache, cacheBatch);
+        }
+    }
+
+public:
+    // Returns the object to the pool it came from
+    struct Deleter {
+        void operator()(T* ptr) const {
+            Slot* slot = reinterpret_cast<Slot*>(ptr);
+            ptr->~T();
+            slot->owner->give(slot);
+        }
+    };
+
+    using Handle = pointers::CustomUniquePtr<T, Deleter>;
+
+    // Allocates `prewarm` slots up front, never more than `capacity` in total
+    explicit ObjectPool(std::size_t capacity, std::size_t prewarm = 0)
+        : _id(nextId()), _capacity(capacity), _free(0), _allocated(0) {
+        this->grow(prewarm);
+        std::lock_guard<std::mutex> lock(livePoolsMtx());
+        livePools().emplace(this->_id, this);
+    }
+
+    ~ObjectPool() {
+        std::lock_guard<std::mutex> lock(livePoolsMtx());
+        livePools().erase(this->_id);
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    // Empty handle when the pool is exhausted
+    template <typename... Args>
+    Handle acquire(Args&&... args) {
+        Slot* slot = this->take();
+        if (slot == nullptr) {
+            return Handle();
+        }
+        try {
+            ::new (static_cast<void*>(slot->storage)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            this->give(slot);
+            throw;
+        }
+        return Handle(reinterpret_cast<T*>(slot->storage));
+    }
+
+    std::size_t capacity() const {
+        return this->_capacity;
+    }
+
+    // Slots allocated so far, free or in use
+    std::size_t allocated() const {
+        return this->_allocated.load(std::memory_order_relaxed);
+    }
+};
+
+}
@@ -1,51 +1,235 @@
 #include "prototype.h"
 
+#include "prototype_snapshot.h"
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
 namespace patterns::creational {
 
-Prototype::Prototype(std::string name, int val) : _name(name), _val(val) { 
+namespace {
+
+// Longest int to_chars writes: digits10 + 1 digits and a sign
+constexpr std::size_t maxIntChars = std::numeric_limits<int>::digits10 + 2;
+
+// Labels of the base and of the longer subclass, with two ints
+constexpr std::size_t representationOverhead =
+    (sizeof("Name: ") - 1) + (sizeof(" Val: ") - 1) + (sizeof(" ValA: ") - 1) + 2 * maxIntChars;
+
+void appendInt(std::string& out, int value) {
+    char digits[16];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+}
+
+Prototype::Prototype(std::string name, int val) : _name(std::move(name)), _val(val) { 
+}
+
+const std::string& Prototype::name() const {
+    return *this->_name;
+}
+
+int Prototype::val() const {
+    return this->_val;
+}
+
+void Prototype::setName(std::string name) {
+    this->_name.assign(std::move(name));
+}
+
+bool Prototype::sharesNameWith(const Prototype& other) const {
+    return this->_name.sharesWith(other._name);
+}
+
+void Prototype::representInto(std::string& out) const {
+    out.append("Name: ").append(*this->_name).append(" Val: ");
+    appendInt(out, this->_val);
 }
 
 std::string Prototype::representation() const {
-    return "Name: " + this->_name + " Val: " + std::to_string(this->_val);
+    std::string out;
+    // Name plus room for the labels and both ints
+    out.reserve(this->_name->size() + representationOverhead);
+    this->representInto(out);
+    return out;
 }
 
 PrototypeA::PrototypeA(std::string name, int val, int valA) 
-    : Prototype(name, val), _valA(valA) { 
+    : Prototype(std::move(name), val), _valA(valA) { 
+}
+
+int PrototypeA::valA() const {
+    return this->_valA;
 }
 
 UniquePrototype PrototypeA::clone() const {
-    return std::make_unique<PrototypeA>(this->_name, this->_val, this->_valA);
+    return std::make_unique<PrototypeA>(*this);
 }
 
-std::string PrototypeA::representation() const {
-    return Prototype::representation() + " ValA: " + std::to_string(this->_valA);
+std::size_t PrototypeA::cloneSize() const {
+    return sizeof(PrototypeA);
+}
+
+Prototype* PrototypeA::cloneInto(void* storage) const {
+    return new (storage) PrototypeA(*this);
+}
+
+void PrototypeA::representInto(std::string& out) const {
+    Prototype::representInto(out);
+    out.append(" ValA: ");
+    appendInt(out, this->_valA);
+}
+
+PrototypeFields PrototypeA::fields() const {
+    return {PrototypeType::PrototypeTypeA, this->_val, this->_valA};
 }
 
 PrototypeB::PrototypeB(std::string name, int val, int valB) 
-    : Prototype(name, val), _valB(valB) { 
+    : Prototype(std::move(name), val), _valB(valB) { 
+}
+
+int PrototypeB::valB() const {
+    return this->_valB;
 }
 
 UniquePrototype PrototypeB::clone() const {
-    return std::make_unique<PrototypeB>(this->_name, this->_val, this->_valB);
+    return std::make_unique<PrototypeB>(*this);
+}
+
+std::size_t PrototypeB::cloneSize() const {
+    return sizeof(PrototypeB);
+}
+
+Prototype* PrototypeB::cloneInto(void* storage) const {
+    return new (storage) PrototypeB(*this);
+}
+
+void PrototypeB::representInto(std::string& out) const {
+    Prototype::representInto(out);
+    out.append(" ValB: ");
+    appendInt(out, this->_valB);
+}
+
+PrototypeFields PrototypeB::fields() const {
+    return {PrototypeType::PrototypeTypeB, this->_val, this->_valB};
 }
 
-std::string PrototypeB::representation() const {
-    return Prototype::representation() + " ValB: " + std::to_string(this->_valB);
+PrototypeBatch::~PrototypeBatch() {
+    this->destroy();
+}
+
+PrototypeBatch::PrototypeBatch(PrototypeBatch&& other) noexcept 
+    : _storage(std::move(other._storage)), _bytes(other._bytes), _objects(std::move(other._objects)) {
+    other._bytes = 0;
+    other._objects.clear();
+}
+
+PrototypeBatch& PrototypeBatch::operator=(PrototypeBatch&& other) noexcept {
+    if (this != &other) {
+        this->destroy();
+        this->_storage = std::move(other._storage);
+        this->_bytes = other._bytes;
+        this->_objects = std::move(other._objects);
+        other._bytes = 0;
+        other._objects.clear();
+    }
+    return *this;
+}
+
+void PrototypeBatch::destroy() {
+    for (auto* object : this->_objects) {
+        object->~Prototype();
+    }
+    this->_objects.clear();
+}
+
+void PrototypeBatch::assign(const Prototype& prototype, std::size_t n) {
+    this->destroy();
+
+    constexpr std::size_t alignment = alignof(std::max_align_t);
+    const std::size_t stride = (prototype.cloneSize() + alignment - 1) / alignment * alignment;
+    if ((n != 0) && (stride > SIZE_MAX / n)) {
+        throw std::length_error("prototype batch of " + std::to_string(n) + " clones is too large");
+    }
+    if ((stride * n) > this->_bytes) {
+        this->_storage.reset(new unsigned char[stride * n]);
+        this->_bytes = stride * n;
+    }
+    this->_objects.reserve(n);
+
+    // _objects only holds finished clones, so a throwing clone leaves a valid batch
+    for (std::size_t i = 0; i < n; ++i) {
+        this->_objects.push_back(prototype.cloneInto(this->_storage.get() + i * stride));
+    }
+}
+
+std::size_t PrototypeBatch::size() const {
+    return this->_objects.size();
+}
+
+Prototype& PrototypeBatch::operator[](std::size_t i) {
+    return *this->_objects[i];
+}
+
+const Prototype& PrototypeBatch::operator[](std::size_t i) const {
+    return *this->_objects[i];
 }
 
 PrototypeFactory::PrototypeFactory() {
-    this->_prototypes.emplace(static_cast<int>(PrototypeType::PrototypeTypeA), 
-        std::make_unique<PrototypeA>("PrototypeA", 1, 1));
-    this->_prototypes.emplace(static_cast<int>(PrototypeType::PrototypeTypeB), 
-        std::make_unique<PrototypeB>("PrototypeB", 2, 2));
+    this->_prototypes[static_cast<std::size_t>(PrototypeType::PrototypeTypeA)] = 
+        std::make_unique<PrototypeA>("PrototypeA", 1, 1);
+    this->_prototypes[static_cast<std::size_t>(PrototypeType::PrototypeTypeB)] = 
+        std::make_unique<PrototypeB>("PrototypeB", 2, 2);
 }
 
-UniquePrototype PrototypeFactory::create(PrototypeType protoType) const {
-    auto it = this->_prototypes.find(static_cast<int>(protoType));
-    if (it == this->_prototypes.end()) {
-        throw std::runtime_error("");
+PrototypeFactory::PrototypeFactory(const PrototypeSnapshot& snapshot) {
+    for (std::size_t i = 0; i < snapshot.size(); ++i) {
+        auto prototype = snapshot.create(i);
+        auto& slot = this->slot(prototype->fields().type);
+        if (slot) {
+            throw std::runtime_error("prototype snapshot registers PrototypeType " +
+                std::to_string(static_cast<int>(prototype->fields().type)) + " twice");
+        }
+        slot = std::move(prototype);
+    }
+}
+
+UniquePrototype& PrototypeFactory::slot(PrototypeType protoType) {
+    const auto index = static_cast<std::size_t>(protoType);
+    if (index >= this->_prototypes.size()) {
+        throw std::runtime_error("cannot register a prototype for PrototypeType " +
+            std::to_string(static_cast<int>(protoType)));
+    }
+    return this->_prototypes[index];
+}
+
+const Prototype& PrototypeFactory::prototype(PrototypeType protoType) const {
+    const auto index = static_cast<std::size_t>(protoType);
+    if ((index >= this->_prototypes.size()) || !this->_prototypes[index]) {
+        throw std::runtime_error("no prototype registered for PrototypeType " + 
+            std::to_string(static_cast<int>(protoType)));
     }
-    return it->second->clone();
+    return *this->_prototypes[index];
+}
+
+void PrototypeFactory::add(UniquePrototype prototype) {
+    if (!prototype) {
+        throw std::runtime_error("prototype factory cannot register a null prototype");
+    }
+    this->slot(prototype->fields().type) = std::move(prototype);
+}
+
+UniquePrototype PrototypeFactory::create(PrototypeType protoType) const {
+    return this->prototype(protoType).clone();
+}
+
+void PrototypeFactory::createBatch(PrototypeType protoType, std::size_t n, PrototypeBatch& out) const {
+    out.assign(this->prototype(protoType), n);
 }
 
 }
\ No newline at end of file
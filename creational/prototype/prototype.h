@@ -1,26 +1,61 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <memory>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <vector>
+
+#include "../../pointers/shared/copy_on_write.h"
 
 namespace patterns::creational {
 
 class Prototype;
 using UniquePrototype = std::unique_ptr<Prototype>;
+class PrototypeSnapshot;
+
+enum class PrototypeType : int {
+    PrototypeTypeA,
+    PrototypeTypeB
+};
+
+// Number of PrototypeType values, keep in sync with the enum
+constexpr std::size_t prototypeTypeCount = 2;
+
+// Everything but the name, flat so a snapshot can store it as is
+struct PrototypeFields {
+    PrototypeType type;
+    int val;
+    // valA or valB, depending on type
+    int extra;
+};
 
 class Prototype {
 protected:
-    std::string _name;
+    // Shared by clones until one of them renames itself
+    pointers::CopyOnWrite<std::string> _name;
     int _val;
 
     Prototype(std::string name, int val);
 
 public:
     virtual ~Prototype() = default;
+    const std::string& name() const;
+    int val() const;
+    void setName(std::string name);
+    bool sharesNameWith(const Prototype& other) const;
     virtual UniquePrototype clone() const = 0;
-    virtual std::string representation() const;
+    // Bytes needed by cloneInto
+    virtual std::size_t cloneSize() const = 0;
+    // Copy constructs into caller provided storage of cloneSize() bytes
+    virtual Prototype* cloneInto(void* storage) const = 0;
+    // Appends the representation to out. Allocates only when out has to grow,
+    // so a reused buffer makes it allocation free.
+    virtual void representInto(std::string& out) const;
+    std::string representation() const;
+    // Serialisation hook, what PrototypeSnapshotWriter records besides the name
+    virtual PrototypeFields fields() const = 0;
 };
 
 class PrototypeA : public Prototype {
@@ -29,8 +64,12 @@ private:
 public:
     PrototypeA(std::string name, int val, int valA);
 
+    int valA() const;
     UniquePrototype clone() const override;
-    std::string representation() const override;
+    std::size_t cloneSize() const override;
+    Prototype* cloneInto(void* storage) const override;
+    void representInto(std::string& out) const override;
+    PrototypeFields fields() const override;
 };
 
 class PrototypeB : public Prototype {
@@ -39,23 +78,60 @@ private:
 public:
     PrototypeB(std::string name, int val, int valB);
 
+    int valB() const;
     UniquePrototype clone() const override;
-    std::string representation() const override;
+    std::size_t cloneSize() const override;
+    Prototype* cloneInto(void* storage) const override;
+    void representInto(std::string& out) const override;
+    PrototypeFields fields() const override;
 };
 
-enum class PrototypeType : int {
-    PrototypeTypeA,
-    PrototypeTypeB
+// Clones of a single prototype laid out back to back in one allocation
+class PrototypeBatch {
+private:
+    std::unique_ptr<unsigned char[]> _storage;
+    std::size_t _bytes = 0;
+    // What cloneInto returned for each finished clone. The Prototype base
+    // need not start where the storage of the derived clone does.
+    std::vector<Prototype*> _objects;
+
+    void destroy();
+
+public:
+    PrototypeBatch() = default;
+    ~PrototypeBatch();
+    PrototypeBatch(PrototypeBatch&& other) noexcept;
+    PrototypeBatch& operator=(PrototypeBatch&& other) noexcept;
+
+    // Replaces the content with n clones of prototype
+    void assign(const Prototype& prototype, std::size_t n);
+    std::size_t size() const;
+    Prototype& operator[](std::size_t i);
+    const Prototype& operator[](std::size_t i) const;
 };
 
 class PrototypeFactory {
 private:
-    std::unordered_map<int, UniquePrototype> _prototypes;
+    // Indexed by PrototypeType
+    std::array<UniquePrototype, prototypeTypeCount> _prototypes;
+
+    // Throws for types outside PrototypeType
+    UniquePrototype& slot(PrototypeType protoType);
 
 public:
     PrototypeFactory();
+    // Registers the prototypes of a snapshot, at most one per PrototypeType.
+    // Types the snapshot does not have stay unregistered. Each name is copied
+    // once here, so the snapshot may be dropped afterwards.
+    explicit PrototypeFactory(const PrototypeSnapshot& snapshot);
     ~PrototypeFactory() = default;
+    // Throws when no prototype is registered for the type
+    const Prototype& prototype(PrototypeType protoType) const;
+    // Registers prototype for the type in its fields(), replacing the one there
+    void add(UniquePrototype prototype);
     UniquePrototype create(PrototypeType protoType) const;
+    // Clones n instances into out with a single allocation
+    void createBatch(PrototypeType protoType, std::size_t n, PrototypeBatch& out) const;
 };
 
 }
\ No newline at end of file
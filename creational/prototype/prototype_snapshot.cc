@@ -0,0 +1,148 @@
+#include "prototype_snapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace patterns::creational {
+
+namespace {
+
+// Layout, all integers in host byte order:
+//   header  magic[8] version:u32 count:u32 namesOffset:u64 namesSize:u64
+//   record  type:i32 val:i32 extra:i32 nameSize:u32 nameOffset:u64, count times
+//   names   raw bytes, nameOffset is relative to namesOffset
+constexpr char magic[8] = {'P', 'R', 'O', 'T', 'O', 'S', 'N', 'P'};
+constexpr std::uint32_t version = 1;
+constexpr std::size_t headerSize = 32;
+constexpr std::size_t recordSize = 24;
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T get(const unsigned char* in, std::size_t offset) {
+    T value;
+    std::memcpy(&value, in + offset, sizeof(value));
+    return value;
+}
+
+}
+
+void PrototypeSnapshotWriter::add(const Prototype& prototype) {
+    const auto fields = prototype.fields();
+    const auto& name = prototype.name();
+    put<std::int32_t>(this->_records, static_cast<std::int32_t>(fields.type));
+    put<std::int32_t>(this->_records, fields.val);
+    put<std::int32_t>(this->_records, fields.extra);
+    put<std::uint32_t>(this->_records, static_cast<std::uint32_t>(name.size()));
+    put<std::uint64_t>(this->_records, this->_names.size());
+    this->_names += name;
+    ++this->_count;
+}
+
+void PrototypeSnapshotWriter::write(const std::string& path) const {
+    std::string header(magic, sizeof(magic));
+    put<std::uint32_t>(header, version);
+    put<std::uint32_t>(header, this->_count);
+    put<std::uint64_t>(header, headerSize + this->_records.size());
+    put<std::uint64_t>(header, this->_names.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(header.data(), header.size());
+    out.write(this->_records.data(), this->_records.size());
+    out.write(this->_names.data(), this->_names.size());
+    if (!out) {
+        throw std::runtime_error("cannot write prototype snapshot " + path);
+    }
+}
+
+PrototypeSnapshot::PrototypeSnapshot(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open prototype snapshot " + path);
+    }
+    struct stat info;
+    if ((::fstat(fd, &info) != 0) || (static_cast<std::size_t>(info.st_size) < headerSize)) {
+        ::close(fd);
+        throw std::runtime_error("prototype snapshot too small: " + path);
+    }
+
+    this->_size = static_cast<std::size_t>(info.st_size);
+    void* data = ::mmap(nullptr, this->_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("cannot map prototype snapshot " + path);
+    }
+    this->_data = static_cast<const unsigned char*>(data);
+
+    const auto count = get<std::uint32_t>(this->_data, 12);
+    const auto namesOffset = get<std::uint64_t>(this->_data, 16);
+    const auto namesSize = get<std::uint64_t>(this->_data, 24);
+    // Compared without sums that could wrap, so a corrupt header cannot
+    // make the records or names reach past the mapping
+    if ((std::memcmp(this->_data, magic, sizeof(magic)) != 0) ||
+        (get<std::uint32_t>(this->_data, 8) != version) ||
+        (count > (this->_size - headerSize) / recordSize) ||
+        (namesOffset != headerSize + static_cast<std::uint64_t>(count) * recordSize) ||
+        (namesOffset > this->_size) || (namesSize != this->_size - namesOffset)) {
+        ::munmap(const_cast<unsigned char*>(this->_data), this->_size);
+        throw std::runtime_error("not a prototype snapshot: " + path);
+    }
+    this->_count = count;
+}
+
+PrototypeSnapshot::~PrototypeSnapshot() {
+    ::munmap(const_cast<unsigned char*>(this->_data), this->_size);
+}
+
+const unsigned char* PrototypeSnapshot::record(std::size_t i) const {
+    if (i >= this->_count) {
+        throw std::out_of_range("prototype snapshot index " + std::to_string(i) + 
+            " out of " + std::to_string(this->_count));
+    }
+    return this->_data + headerSize + i * recordSize;
+}
+
+std::size_t PrototypeSnapshot::size() const {
+    return this->_count;
+}
+
+PrototypeType PrototypeSnapshot::type(std::size_t i) const {
+    return static_cast<PrototypeType>(get<std::int32_t>(this->record(i), 0));
+}
+
+std::string_view PrototypeSnapshot::name(std::size_t i) const {
+    const auto* rec = this->record(i);
+    const auto size = get<std::uint32_t>(rec, 12);
+    const auto offset = get<std::uint64_t>(rec, 16);
+    const std::size_t namesOffset = headerSize + this->_count * recordSize;
+    const std::size_t namesSize = this->_size - namesOffset;
+    if ((offset > namesSize) || (size > namesSize - offset)) {
+        throw std::runtime_error("prototype snapshot name out of bounds at " + std::to_string(i));
+    }
+    return std::string_view(reinterpret_cast<const char*>(this->_data + namesOffset + offset), size);
+}
+
+UniquePrototype PrototypeSnapshot::create(std::size_t i) const {
+    const auto* rec = this->record(i);
+    const auto val = get<std::int32_t>(rec, 4);
+    const auto extra = get<std::int32_t>(rec, 8);
+    std::string name(this->name(i));
+    switch (this->type(i)) {
+    case PrototypeType::PrototypeTypeA:
+        return std::make_unique<PrototypeA>(std::move(name), val, extra);
+    case PrototypeType::PrototypeTypeB:
+        return std::make_unique<PrototypeB>(std::move(name), val, extra);
+    }
+    throw std::runtime_error("prototype snapshot has unknown type at " + std::to_string(i));
+}
+
+}
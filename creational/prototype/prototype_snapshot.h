@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "prototype.h"
+
+namespace patterns::creational {
+
+// Collects prototypes and writes them as a binary snapshot:
+// a fixed header, one fixed size record per prototype, then all names.
+class PrototypeSnapshotWriter {
+private:
+    std::string _records;
+    std::string _names;
+    std::uint32_t _count = 0;
+
+public:
+    PrototypeSnapshotWriter() = default;
+    ~PrototypeSnapshotWriter() = default;
+
+    // Records the name and the fields() of any prototype
+    void add(const Prototype& prototype);
+    void write(const std::string& path) const;
+};
+
+// Read only view of a snapshot file mapped into memory. Loading validates the
+// header and nothing else, records and names are read in place on access.
+class PrototypeSnapshot {
+private:
+    const unsigned char* _data = nullptr;
+    std::size_t _size = 0;
+    std::uint32_t _count = 0;
+
+    const unsigned char* record(std::size_t i) const;
+
+public:
+    // Throws when the file cannot be mapped or is not a snapshot
+    explicit PrototypeSnapshot(const std::string& path);
+    ~PrototypeSnapshot();
+
+    PrototypeSnapshot(const PrototypeSnapshot&) = delete;
+    PrototypeSnapshot& operator=(const PrototypeSnapshot&) = delete;
+
+    std::size_t size() const;
+    PrototypeType type(std::size_t i) const;
+    // Points into the mapping, valid while the snapshot lives
+    std::string_view name(std::size_t i) const;
+    // Copies the name out of the mapping, the prototype owns it and outlives
+    // the snapshot. Its clones share that copy.
+    UniquePrototype create(std::size_t i) const;
+};
+
+}
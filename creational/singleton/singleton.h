@@ -1,25 +1,86 @@
 #pragma once
 
-#include <memory>
+#include <atomic>
 #include <mutex>
-#include <iostream>
+#include <new>
 
 namespace patterns::creational {
 
+// Lazily constructed process wide instance of T.
+// The instance lives in static storage, so get() never touches the heap,
+// and once it exists get() is a single acquire load without any lock.
+// T opts in by making Singleton<T> a friend of its private constructor.
+template <typename T>
 class Singleton final {
 private:
-  static std::unique_ptr<Singleton> _singleton;
+  alignas(T) static unsigned char _storage[sizeof(T)];
+  static std::atomic<T*> _instance;
   static std::mutex _mtx;
-  Singleton() = default;
-  Singleton(const Singleton&) = delete;
-  Singleton& operator=(const Singleton&) = delete;
-  Singleton(Singleton&&) = delete;
-  Singleton& operator=(Singleton&&) = delete;
+
+  // Destroys the instance at exit, in reverse order of construction
+  struct Destroyer {
+    ~Destroyer() {
+      T* instance = Singleton::_instance.exchange(nullptr, std::memory_order_acq_rel);
+      if (instance != nullptr) {
+        instance->~T();
+      }
+    }
+  };
+
+  static T* create() {
+    std::lock_guard<std::mutex> lock(Singleton::_mtx);
+    T* instance = Singleton::_instance.load(std::memory_order_relaxed);
+    if (instance == nullptr) {
+      instance = ::new (static_cast<void*>(Singleton::_storage)) T();
+      Singleton::_instance.store(instance, std::memory_order_release);
+      // Registered only once T is complete, after any singleton T's constructor
+      // got, so those are destroyed after T
+      static Destroyer destroyer;
+    }
+    return instance;
+  }
+
 public:
-  static Singleton* get();
-  void hi() const {
-    std::cout << "Hi" << std::endl;
+  Singleton() = delete;
+
+  static T* get() {
+    T* instance = Singleton::_instance.load(std::memory_order_acquire);
+    if (instance != nullptr) {
+      return instance;
+    }
+    return Singleton::create();
+  }
+
+  // Destroys the instance ahead of exit, e.g. for ordered teardown.
+  // Nobody may still use the instance; a later get() constructs a new one.
+  static void destroy() {
+    std::lock_guard<std::mutex> lock(Singleton::_mtx);
+    T* instance = Singleton::_instance.exchange(nullptr, std::memory_order_acq_rel);
+    if (instance != nullptr) {
+      instance->~T();
+    }
   }
 };
 
-}
\ No newline at end of file
+template <typename T>
+alignas(T) unsigned char Singleton<T>::_storage[sizeof(T)];
+
+template <typename T>
+std::atomic<T*> Singleton<T>::_instance{nullptr};
+
+template <typename T>
+std::mutex Singleton<T>::_mtx;
+
+class Greeter final {
+private:
+  friend class Singleton<Greeter>;
+  Greeter() = default;
+  Greeter(const Greeter&) = delete;
+  Greeter& operator=(const Greeter&) = delete;
+  Greeter(Greeter&&) = delete;
+  Greeter& operator=(Greeter&&) = delete;
+public:
+  void hi() const;
+};
+
+}
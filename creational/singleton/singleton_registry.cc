@@ -0,0 +1,111 @@
+#include "singleton_registry.h"
+
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+#include "../../concurrency/thread_pool.h"
+
+namespace patterns::creational {
+
+void SingletonRegistry::add(std::string name, Action init, Action teardown, std::vector<std::string> dependencies) {
+    if (this->_index.find(name) != this->_index.end()) {
+        throw std::runtime_error("singleton registered twice: " + name);
+    }
+    this->_index.emplace(name, this->_entries.size());
+    this->_entries.push_back({std::move(name), std::move(init), std::move(teardown), std::move(dependencies)});
+}
+
+std::vector<std::vector<std::size_t>> SingletonRegistry::dependents() const {
+    std::vector<std::vector<std::size_t>> result(this->_entries.size());
+    for (std::size_t i = 0; i < this->_entries.size(); ++i) {
+        for (const auto& dependency : this->_entries[i].dependencies) {
+            auto it = this->_index.find(dependency);
+            if (it == this->_index.end()) {
+                throw std::runtime_error("singleton " + this->_entries[i].name + 
+                    " depends on unknown singleton " + dependency);
+            }
+            result[it->second].push_back(i);
+        }
+    }
+    return result;
+}
+
+void SingletonRegistry::initialize(std::size_t threads) {
+    const auto dependents = this->dependents();
+    std::vector<std::size_t> pending(this->_entries.size());
+    std::vector<std::size_t> ready;
+    for (std::size_t i = 0; i < this->_entries.size(); ++i) {
+        pending[i] = this->_entries[i].dependencies.size();
+        if (pending[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    // Reject cycles up front rather than waiting forever on them
+    auto remaining = pending;
+    auto order = ready;
+    for (std::size_t next = 0; next < order.size(); ++next) {
+        for (auto dependent : dependents[order[next]]) {
+            if (--remaining[dependent] == 0) {
+                order.push_back(dependent);
+            }
+        }
+    }
+    if (order.size() != this->_entries.size()) {
+        throw std::runtime_error("singleton dependency cycle");
+    }
+
+    std::mutex mtx;
+    std::exception_ptr failure;
+    concurrency::ThreadPool pool(threads);
+
+    std::function<void(std::size_t)> run = [&](std::size_t i) {
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            this->_entries[i].init();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            return;
+        }
+        const auto duration = std::chrono::steady_clock::now() - start;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        this->_initialized.push_back(i);
+        this->_timings.push_back({this->_entries[i].name,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration)});
+        if (failure) {
+            return;
+        }
+        for (auto dependent : dependents[i]) {
+            if (--pending[dependent] == 0) {
+                pool.submit([&run, dependent]() { run(dependent); });
+            }
+        }
+    };
+
+    for (auto i : ready) {
+        pool.submit([&run, i]() { run(i); });
+    }
+    pool.wait();
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void SingletonRegistry::teardown() {
+    for (auto it = this->_initialized.rbegin(); it != this->_initialized.rend(); ++it) {
+        this->_entries[*it].teardown();
+    }
+    this->_initialized.clear();
+}
+
+const std::vector<SingletonRegistry::InitTiming>& SingletonRegistry::timings() const {
+    return this->_timings;
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "singleton.h"
+
+namespace patterns::creational {
+
+// Warms up expensive singletons at startup instead of on their first get().
+// Singletons without a dependency path between them are initialized in
+// parallel, teardown runs in reverse dependency order.
+class SingletonRegistry final {
+public:
+    using Action = std::function<void()>;
+
+    struct InitTiming {
+        std::string name;
+        std::chrono::nanoseconds duration;
+    };
+
+private:
+    struct Entry {
+        std::string name;
+        Action init;
+        Action teardown;
+        std::vector<std::string> dependencies;
+    };
+
+    std::vector<Entry> _entries;
+    std::unordered_map<std::string, std::size_t> _index;
+    // Entries in the order they finished initializing
+    std::vector<std::size_t> _initialized;
+    std::vector<InitTiming> _timings;
+
+    std::vector<std::vector<std::size_t>> dependents() const;
+
+public:
+    SingletonRegistry() = default;
+    ~SingletonRegistry() = default;
+
+    void add(std::string name, Action init, Action teardown, std::vector<std::string> dependencies = {});
+
+    template <typename T>
+    void add(std::string name, std::vector<std::string> dependencies = {}) {
+        this->add(std::move(name),
+            []() { Singleton<T>::get(); },
+            []() { Singleton<T>::destroy(); },
+            std::move(dependencies));
+    }
+
+    // Runs every initializer once its dependencies are done, using the given
+    // number of threads. Throws on unknown dependencies, cycles or the first
+    // failed initializer; whatever was initialized stays up for teardown().
+    void initialize(std::size_t threads);
+    // Tears initialized singletons down, dependents before their dependencies
+    void teardown();
+
+    // Init time of every initialized singleton, in completion order
+    const std::vector<InitTiming>& timings() const;
+};
+
+}
@@ -1,14 +1,45 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <latch>
 #include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "concurrency/executor.h"
+#include "concurrency/task.h"
+#include "concurrency/thread_pool.h"
 #include "creational/builder/builder.h"
+#include "creational/builder/menu_exporter.h"
 #include "creational/factorymethod/factorymethod.h"
+#include "creational/factorymethod/shape_registry.h"
+#include "creational/factorymethod/shape_variant.h"
+#include "creational/objectpool/object_pool.h"
 #include "creational/prototype/prototype.h"
+#include "creational/prototype/prototype_snapshot.h"
 #include "creational/singleton/singleton.h"
+#include "creational/singleton/singleton_registry.h"
+#include "pointers/intrusive/custom_intrusive_ptr.h"
+#include "pointers/shared/atomic_custom_shared_ptr.h"
+#include "pointers/shared/copy_on_write.h"
 #include "pointers/shared/custom_shared_ptr.h"
+#include "pointers/shared/custom_weak_ptr.h"
 #include "pointers/unique/custom_unique_ptr.h"
 #include "structural/adapter/adapter.h"
+#include "structural/proxy/allowlist.h"
+#include "structural/proxy/caching_proxy.h"
+#include "structural/proxy/coalescing_proxy.h"
 #include "structural/proxy/proxy.h"
+#include "structural/proxy/rate_limiting_proxy.h"
 
 namespace {
 
@@ -16,14 +47,66 @@ namespace pc = patterns::creational;
 namespace pp = patterns::pointers;
 namespace ps = patterns::structural;
 
-void createSingleton(std::vector<pc::Singleton*>& instances, std::mutex& mtx) {
+void createSingleton(std::vector<pc::Greeter*>& instances, std::mutex& mtx) {
     std::lock_guard<std::mutex> lock(mtx);
-    instances.push_back(pc::Singleton::get());
+    instances.push_back(pc::Singleton<pc::Greeter>::get());
 }
 
+// Counts constructions to prove get() builds the instance once
+class Expensive final {
+private:
+    friend class pc::Singleton<Expensive>;
+    Expensive() {
+        ++constructed;
+    }
+public:
+    static std::atomic<int> constructed;
+};
+
+std::atomic<int> Expensive::constructed{0};
+
+// Singletons depending on each other. Destruction at exit runs in reverse
+// order of construction, so SingletonDependency outlives SingletonUser.
+// That can only be checked at exit, where a failure ends the process.
+class SingletonDependency final {
+private:
+    friend class pc::Singleton<SingletonDependency>;
+    SingletonDependency() {
+        ++constructed;
+        alive = true;
+    }
+    ~SingletonDependency() {
+        alive = false;
+    }
+public:
+    static std::atomic<int> constructed;
+    static std::atomic<bool> alive;
+};
+
+std::atomic<int> SingletonDependency::constructed{0};
+std::atomic<bool> SingletonDependency::alive{false};
+
+class SingletonUser final {
+private:
+    friend class pc::Singleton<SingletonUser>;
+    SingletonDependency* _dependency;
+    SingletonUser() : _dependency(pc::Singleton<SingletonDependency>::get()) { }
+    ~SingletonUser() {
+        if (!SingletonDependency::alive || (pc::Singleton<SingletonDependency>::get() != this->_dependency) ||
+            (SingletonDependency::constructed != 1)) {
+            std::fprintf(stderr, "Singleton pattern failed: dependency destroyed first\n");
+            std::_Exit(1);
+        }
+    }
+public:
+    bool ready() const {
+        return SingletonDependency::alive && (this->_dependency != nullptr);
+    }
+};
+
 void singletonTest() {
     std::mutex mtx;
-    std::vector<pc::Singleton*> instances = {};
+    std::vector<pc::Greeter*> instances = {};
     std::vector<std::thread> threads;
 
     constexpr int num = 10;
@@ -44,6 +127,92 @@ void singletonTest() {
             throw std::runtime_error("Singleton pattern failed");    
         }
     }
+
+    // Many threads racing on the first get() and then hammering the fast path
+    constexpr int racers = 32;
+    std::vector<Expensive*> seen(racers, nullptr);
+    threads.clear();
+    for (int i = 0; i < racers; ++i) {
+        threads.emplace_back([&seen, i]() {
+            for (int j = 0; j < 1000; ++j) {
+                Expensive* instance = pc::Singleton<Expensive>::get();
+                if ((seen[i] != nullptr) && (seen[i] != instance)) {
+                    throw std::runtime_error("Singleton pattern failed");
+                }
+                seen[i] = instance;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (int i = 1; i < racers; ++i) {
+        if (seen[i] != seen[0]) {
+            throw std::runtime_error("Singleton pattern failed");
+        }
+    }
+    if (Expensive::constructed != 1) {
+        throw std::runtime_error("Singleton pattern failed");
+    }
+
+    // The dependency is built from inside the user's constructor
+    if (!pc::Singleton<SingletonUser>::get()->ready() || (SingletonDependency::constructed != 1)) {
+        throw std::runtime_error("Singleton pattern failed");
+    }
+}
+
+void singletonRegistryTest() {
+    std::mutex mtx;
+    std::vector<std::string> events;
+    auto record = [&events, &mtx](const std::string& event) {
+        return [&events, &mtx, event]() {
+            std::lock_guard<std::mutex> lock(mtx);
+            events.push_back(event);
+        };
+    };
+    auto position = [&events](const std::string& event) {
+        return std::find(events.begin(), events.end(), event) - events.begin();
+    };
+
+    pc::SingletonRegistry registry;
+    registry.add("cache", record("init cache"), record("down cache"), {"db", "logger"});
+    registry.add("db", record("init db"), record("down db"), {"config"});
+    registry.add("logger", record("init logger"), record("down logger"), {"config"});
+    registry.add("config", record("init config"), record("down config"));
+    registry.add<pc::Greeter>("greeter");
+
+    registry.initialize(4);
+    if ((events.size() != 4) || (registry.timings().size() != 5)) {
+        throw std::runtime_error("singleton registry failed");
+    }
+    if ((position("init config") > position("init db")) || (position("init config") > position("init logger")) ||
+        (position("init db") > position("init cache")) || (position("init logger") > position("init cache"))) {
+        throw std::runtime_error("singleton registry failed");
+    }
+
+    events.clear();
+    registry.teardown();
+    if ((events.size() != 4) || (events.front() != "down cache") || (events.back() != "down config")) {
+        throw std::runtime_error("singleton registry failed");
+    }
+
+    // Cycles and unknown dependencies are rejected before anything runs
+    auto rejects = [](pc::SingletonRegistry& invalid) {
+        try {
+            invalid.initialize(2);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    pc::SingletonRegistry cyclic;
+    cyclic.add("a", [] {}, [] {}, {"b"});
+    cyclic.add("b", [] {}, [] {}, {"a"});
+    pc::SingletonRegistry unknown;
+    unknown.add("a", [] {}, [] {}, {"missing"});
+    if (!rejects(cyclic) || !rejects(unknown)) {
+        throw std::runtime_error("singleton registry failed");
+    }
 }
 
 void factoryMethodTest() {
@@ -61,6 +230,229 @@ void factoryMethodTest() {
     }
 }
 
+void shapeRegistryTest() {
+    // Self registered shapes
+    const auto& global = pc::ShapeRegistry::global();
+    if ((global.create("triangle")->draw() != "triangle") || (global.create("rectangle")->draw() != "rectangle")) {
+        throw std::runtime_error("shape registry failed");
+    }
+
+    pc::ShapeRegistry registry;
+    for (int i = 0; i < 300; ++i) {
+        registry.add("shape" + std::to_string(i), (i % 2 == 0)
+            ? pc::ShapeRegistry::Creator([]() -> pc::UniqueShape { return std::make_unique<pc::Triangle>(); })
+            : pc::ShapeRegistry::Creator([]() -> pc::UniqueShape { return std::make_unique<pc::Rectangle>(); }));
+    }
+    // Names shorter than a hash word
+    for (const auto* name : {"a", "ab", "abc", "abcd"}) {
+        registry.add(name, []() -> pc::UniqueShape { return std::make_unique<pc::Triangle>(); });
+    }
+    registry.freeze();
+    for (int i = 0; i < 300; ++i) {
+        const auto expected = (i % 2 == 0) ? "triangle" : "rectangle";
+        if (registry.create("shape" + std::to_string(i))->draw() != expected) {
+            throw std::runtime_error("shape registry failed");
+        }
+    }
+    if ((registry.find("abc") == nullptr) || (registry.find("a") == nullptr) || (registry.find("abd") != nullptr) ||
+        (registry.find("b") != nullptr) || (registry.find("shape300") != nullptr) || (registry.find("") != nullptr)) {
+        throw std::runtime_error("shape registry failed");
+    }
+
+    // Generated key sets, sizes a weak slot hash used to fail on
+    for (int count : {423, 1000, 3000}) {
+        pc::ShapeRegistry generated;
+        for (int i = 0; i < count; ++i) {
+            generated.add("shape" + std::to_string(i), []() -> pc::UniqueShape { return std::make_unique<pc::Triangle>(); });
+        }
+        generated.freeze();
+        for (int i = 0; i < count; ++i) {
+            if (generated.find("shape" + std::to_string(i)) == nullptr) {
+                throw std::runtime_error("shape registry failed");
+            }
+        }
+        if (generated.find("shape" + std::to_string(count)) != nullptr) {
+            throw std::runtime_error("shape registry failed");
+        }
+    }
+
+    auto throws = [](const std::function<void()>& func) {
+        try {
+            func();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    if (!throws([&registry]() { registry.create("circle"); }) ||
+        !throws([&registry]() { registry.add("circle", nullptr); })) {
+        throw std::runtime_error("shape registry failed");
+    }
+}
+
+void shapeVariantTest() {
+    // Same text as the virtual shapes
+    if ((pc::draw(pc::TriangleValue()) != pc::Triangle().draw()) ||
+        (pc::draw(pc::RectangleValue()) != pc::Rectangle().draw())) {
+        throw std::runtime_error("shape variant failed");
+    }
+
+    pc::ShapeBatch batch;
+    batch.add(pc::TriangleValue());
+    batch.add(pc::RectangleValue());
+
+    std::string res;
+    batch.drawInto(res);
+    if ((res != "name: triangle; name: rectangle; ") || (res.size() != batch.drawnSize())) {
+        throw std::runtime_error("shape variant failed");
+    }
+
+    std::vector<char> buffer(batch.drawnSize());
+    if (batch.drawInto(buffer.data()) != buffer.data() + buffer.size()) {
+        throw std::runtime_error("shape variant failed");
+    }
+}
+
+struct Pooled {
+    static std::atomic<int> alive;
+    int value;
+
+    explicit Pooled(int value) : value(value) {
+        ++alive;
+    }
+    ~Pooled() {
+        --alive;
+    }
+};
+
+std::atomic<int> Pooled::alive{0};
+
+void objectPoolTest() {
+    using TrianglePool = pc::ObjectPool<pc::Triangle>;
+    static_assert(sizeof(TrianglePool::Handle) == sizeof(pc::Triangle*), "pooled handle must be one word");
+
+    // Released storage is handed out again, prewarmed slots count as allocated
+    TrianglePool pool(4, 2);
+    if ((pool.allocated() != 2) || (pool.capacity() != 4)) {
+        throw std::runtime_error("object pool failed");
+    }
+    auto triangle = pool.acquire();
+    const pc::Triangle* address = triangle.get();
+    if (triangle->draw() != "triangle") {
+        throw std::runtime_error("object pool failed");
+    }
+    triangle.reset();
+    if (pool.acquire().get() != address) {
+        throw std::runtime_error("object pool failed");
+    }
+
+    // Capacity is a hard cap
+    std::vector<TrianglePool::Handle> held;
+    for (int i = 0; i < 4; ++i) {
+        held.push_back(pool.acquire());
+    }
+    if (pool.acquire() || (pool.allocated() != 4)) {
+        throw std::runtime_error("object pool failed");
+    }
+    held.clear();
+
+    // Objects move between threads and each one is constructed once per acquire
+    pc::ObjectPool<Pooled> pooled(256);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pooled, t]() {
+            std::vector<pc::ObjectPool<Pooled>::Handle> handles;
+            for (int i = 0; i < 5000; ++i) {
+                auto handle = pooled.acquire(t);
+                if (handle) {
+                    handles.push_back(std::move(handle));
+                }
+                if ((handles.size() > 40) || (i % 7 == 0)) {
+                    handles.clear();
+                }
+            }
+            for (const auto& handle : handles) {
+                if (handle->value != t) {
+                    throw std::runtime_error("object pool failed");
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    if ((Pooled::alive != 0) || (pooled.allocated() > 256)) {
+        throw std::runtime_error("object pool failed");
+    }
+
+    // Slots parked in the caches of threads that are still alive can be acquired
+    TrianglePool parking(64);
+    std::latch parked(3);
+    std::latch drained(1);
+    threads.clear();
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&parking, &parked, &drained]() {
+            parking.acquire().reset();
+            parked.count_down();
+            drained.wait();
+        });
+    }
+    parked.wait();
+    held.clear();
+    for (auto handle = parking.acquire(); handle; handle = parking.acquire()) {
+        held.push_back(std::move(handle));
+    }
+    drained.count_down();
+    for (auto& t : threads) {
+        t.join();
+    }
+    if ((held.size() != 64) || (parking.allocated() != 64)) {
+        throw std::runtime_error("object pool failed");
+    }
+    held.clear();
+}
+
+// Puts the Prototype base behind another polymorphic base, so it does not
+// start where the clone's storage does
+struct Tagged {
+    long tag = 42;
+    virtual ~Tagged() = default;
+};
+
+class OffsetPrototype final : public Tagged, public pc::PrototypeA {
+public:
+    using PrototypeA::PrototypeA;
+
+    std::size_t cloneSize() const override {
+        return sizeof(OffsetPrototype);
+    }
+    pc::Prototype* cloneInto(void* storage) const override {
+        return new (storage) OffsetPrototype(*this);
+    }
+};
+
+// Claims a clone size no batch can hold
+class OversizedPrototype final : public pc::PrototypeA {
+public:
+    using PrototypeA::PrototypeA;
+
+    std::size_t cloneSize() const override {
+        return SIZE_MAX / 2;
+    }
+};
+
+// Reports a PrototypeType the factory has no slot for
+class UnknownTypePrototype final : public pc::PrototypeA {
+public:
+    using PrototypeA::PrototypeA;
+
+    pc::PrototypeFields fields() const override {
+        auto fields = PrototypeA::fields();
+        fields.type = static_cast<pc::PrototypeType>(7);
+        return fields;
+    }
+};
+
 void prototypeTest() {
     pc::PrototypeFactory factory;
     auto protoB = factory.create(pc::PrototypeType::PrototypeTypeB);
@@ -77,8 +469,192 @@ void prototypeTest() {
     if (res != "Name: PrototypeB Val: 2 ValB: 2/nName: PrototypeA Val: 1 ValA: 1/n") {
         throw std::runtime_error("prototype failed");
     }
+
+    // Batch clones share one allocation
+    pc::PrototypeBatch batch;
+    factory.createBatch(pc::PrototypeType::PrototypeTypeA, 3, batch);
+    factory.createBatch(pc::PrototypeType::PrototypeTypeB, 2, batch);
+    if ((batch.size() != 2) || (batch[1].representation() != "Name: PrototypeB Val: 2 ValB: 2")) {
+        throw std::runtime_error("prototype failed");
+    }
+    auto moved = std::move(batch);
+    if ((batch.size() != 0) || (moved[0].representation() != protoB->representation())) {
+        throw std::runtime_error("prototype failed");
+    }
+
+    const OffsetPrototype offset("Offset", 5, 6);
+    if (static_cast<const void*>(static_cast<const pc::Prototype*>(&offset)) == static_cast<const void*>(&offset)) {
+        throw std::runtime_error("prototype failed");
+    }
+    batch.assign(offset, 2);
+    if ((batch.size() != 2) || (batch[1].representation() != "Name: Offset Val: 5 ValA: 6")) {
+        throw std::runtime_error("prototype failed");
+    }
+    try {
+        batch.assign(OversizedPrototype("Oversized", 1, 1), 3);
+        throw std::runtime_error("prototype failed");
+    } catch (const std::length_error&) {
+    }
+    if (batch.size() != 0) {
+        throw std::runtime_error("prototype failed");
+    }
+
+    // Clones share the name until one of them changes it
+    auto clone = factory.create(pc::PrototypeType::PrototypeTypeB);
+    if (!clone->sharesNameWith(*protoB) || !moved[1].sharesNameWith(*protoB)) {
+        throw std::runtime_error("prototype failed");
+    }
+    clone->setName("Renamed");
+    if (clone->sharesNameWith(*protoB) || (protoB->name() != "PrototypeB") ||
+        (clone->representation() != "Name: Renamed Val: 2 ValB: 2")) {
+        throw std::runtime_error("prototype failed");
+    }
+
+    // A copy read on another thread and dropped there, the flag is relaxed so
+    // only the count orders that read before the write in place
+    pp::CopyOnWrite<std::string> value(std::string("value"));
+    std::atomic<bool> dropped{false};
+    std::thread reader([copy = value, &dropped]() mutable {
+        if (copy->size() != 5) {
+            throw std::runtime_error("prototype failed");
+        }
+        copy = pp::CopyOnWrite<std::string>(std::string());
+        dropped.store(true, std::memory_order_relaxed);
+    });
+    while (!dropped.load(std::memory_order_relaxed)) {
+        std::this_thread::yield();
+    }
+    value.mutate() += "!";
+    reader.join();
+    if (*value != "value!") {
+        throw std::runtime_error("prototype failed");
+    }
+
+    // representInto appends, so a reused buffer can hold several objects
+    std::string line = "> ";
+    protoB->representInto(line);
+    line += " | ";
+    clone->representInto(line);
+    if (line != "> Name: PrototypeB Val: 2 ValB: 2 | Name: Renamed Val: 2 ValB: 2") {
+        throw std::runtime_error("prototype failed");
+    }
+
+    // Unknown types name themselves in the error
+    try {
+        factory.create(static_cast<pc::PrototypeType>(7));
+        throw std::runtime_error("prototype failed");
+    } catch (const std::runtime_error& e) {
+        if (std::string(e.what()).find("7") == std::string::npos) {
+            throw std::runtime_error("prototype failed");
+        }
+    }
+    try {
+        factory.add(std::make_unique<UnknownTypePrototype>("Unknown", 1, 1));
+        throw std::runtime_error("prototype failed");
+    } catch (const std::runtime_error& e) {
+        if (std::string(e.what()).find("cannot register") == std::string::npos) {
+            throw std::runtime_error("prototype failed");
+        }
+    }
+}
+
+// Creates an empty file of its own, so parallel runs never share one
+std::string uniqueTempPath(const std::string& prefix) {
+    std::string path = (std::filesystem::temp_directory_path() / (prefix + ".XXXXXX")).string();
+    const int fd = ::mkstemp(path.data());
+    if (fd < 0) {
+        throw std::runtime_error("cannot create a temporary file for " + prefix);
+    }
+    ::close(fd);
+    return path;
 }
 
+void prototypeSnapshotTest() {
+    const std::string path = uniqueTempPath("prototype_snapshot_test");
+    // Written through the Prototype interface, straight from a factory
+    const pc::PrototypeFactory factory;
+    pc::PrototypeSnapshotWriter writer;
+    writer.add(factory.prototype(pc::PrototypeType::PrototypeTypeA));
+    writer.add(factory.prototype(pc::PrototypeType::PrototypeTypeB));
+    writer.add(pc::PrototypeA(std::string(100, 'a'), 3, 4));
+    writer.write(path);
+
+    {
+        pc::PrototypeSnapshot snapshot(path);
+        if ((snapshot.size() != 3) || (snapshot.type(1) != pc::PrototypeType::PrototypeTypeB) ||
+            (snapshot.name(2) != std::string(100, 'a'))) {
+            throw std::runtime_error("prototype snapshot failed");
+        }
+        if ((snapshot.create(0)->representation() != "Name: PrototypeA Val: 1 ValA: 1") ||
+            (snapshot.create(1)->representation() != "Name: PrototypeB Val: 2 ValB: 2")) {
+            throw std::runtime_error("prototype snapshot failed");
+        }
+
+        // A factory loads one prototype per type, the third record repeats PrototypeTypeA
+        try {
+            pc::PrototypeFactory duplicated(snapshot);
+            throw std::logic_error("prototype snapshot failed");
+        } catch (const std::runtime_error&) {
+        }
+    }
+
+    pc::PrototypeSnapshotWriter registry;
+    registry.add(pc::PrototypeB("loadedB", 5, 6));
+    registry.add(pc::PrototypeA("loadedA", 7, 8));
+    registry.write(path);
+    {
+        const pc::PrototypeFactory loaded{pc::PrototypeSnapshot(path)};
+        if ((loaded.create(pc::PrototypeType::PrototypeTypeA)->representation() != "Name: loadedA Val: 7 ValA: 8") ||
+            (loaded.create(pc::PrototypeType::PrototypeTypeB)->representation() != "Name: loadedB Val: 5 ValB: 6")) {
+            throw std::runtime_error("prototype snapshot failed");
+        }
+    }
+
+    // Anything else is rejected on load
+    std::ofstream(path, std::ios::trunc) << "definitely not a prototype snapshot";
+    try {
+        pc::PrototypeSnapshot snapshot(path);
+        throw std::logic_error("prototype snapshot failed");
+    } catch (const std::runtime_error&) {
+    }
+
+    // A header whose sizes only add up modulo 2^64 is rejected too
+    {
+        std::string header("PROTOSNP", 8);
+        auto put = [&header](auto value) {
+            header.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+        const std::uint64_t namesOffset = 32 + 1000000ull * 24;
+        put(std::uint32_t(1));
+        put(std::uint32_t(1000000));
+        put(namesOffset);
+        put(std::uint64_t(32) - namesOffset);
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << header;
+    }
+    try {
+        pc::PrototypeSnapshot snapshot(path);
+        throw std::logic_error("prototype snapshot failed");
+    } catch (const std::runtime_error&) {
+    }
+    std::remove(path.c_str());
+}
+
+// Cooks a limited number of entries, shared by every builder of a batch
+class FailingDinnerBuilder final : public pc::BbqDinnerBuilder {
+private:
+    std::atomic<int>& _entriesLeft;
+
+public:
+    explicit FailingDinnerBuilder(std::atomic<int>& entriesLeft) : _entriesLeft(entriesLeft) { }
+
+    void makeEntry() const override {
+        if (this->_entriesLeft.fetch_sub(1) <= 0) {
+            throw std::runtime_error("out of ribs");
+        }
+        BbqDinnerBuilder::makeEntry();
+    }
+};
+
 void builderTest() {
     pc::BbqDinnerBuilder bbqBuilder;
     pc::DinnerDirector director(&bbqBuilder);
@@ -93,9 +669,170 @@ void builderTest() {
     director.fullDinner();
     auto fullDinner = bbqBuilder.getDinner();
     auto fullBbqMeal = fullDinner->menu();
-    if (fullBbqMeal != "shrimp cocktail;bbq ribs;ice cream") {
+    if ((fullBbqMeal != "shrimp cocktail;bbq ribs;ice cream") || (fullDinner->menuSize() != fullBbqMeal.size())) {
+        throw std::runtime_error("builder failed");
+    }
+
+    // Compile time recipes give the same menus as the runtime builder
+    static_assert(pc::StaticLiteDinner<pc::BbqKitchen>::menu() == "bbq ribs");
+    static_assert(pc::StaticFullDinner<pc::BbqKitchen>::menu() == "shrimp cocktail;bbq ribs;ice cream");
+    static_assert(pc::StaticDinner<pc::BbqKitchen>::menu().empty());
+    if ((pc::StaticLiteDinner<pc::BbqKitchen>::menu() != liteBbqMeal) ||
+        (pc::StaticFullDinner<pc::BbqKitchen>::menu() != fullBbqMeal)) {
+        throw std::runtime_error("builder failed");
+    }
+
+    // Items are interned, the same name always maps to the same id
+    pc::DinnerMenu custom;
+    custom.add("bbq ribs");
+    custom.add("corn bread");
+    custom.add("corn bread");
+    const auto& items = custom.items();
+    if ((items[0] != liteDinner->items()[0]) || (items[1] != items[2]) ||
+        (custom.menu() != "bbq ribs;corn bread;corn bread") ||
+        (pc::MenuItemTable::global().name(items[1]) != "corn bread")) {
+        throw std::runtime_error("builder failed");
+    }
+    if (!pc::DinnerMenu().menu().empty()) {
+        throw std::runtime_error("builder failed");
+    }
+
+    // Recycled dinners come back as the next product
+    pc::DinnerMenu* recycled = fullDinner.get();
+    bbqBuilder.recycle(std::move(fullDinner));
+    bbqBuilder.getDinner();
+    director.liteDinner();
+    if ((bbqBuilder.getDinner().get() != recycled) || (recycled->menu() != "bbq ribs")) {
         throw std::runtime_error("builder failed");
     }
+
+    // Batches reuse both the builders and the dinners already in the output
+    patterns::concurrency::ThreadPool pool(4);
+    pc::BatchDinnerDirector batchDirector(pool, []() {
+        return std::make_unique<pc::BbqDinnerBuilder>();
+    });
+    std::vector<pc::DinnerMenu> dinners;
+    batchDirector.produce(1001, &pc::DinnerDirector::fullDinner, dinners);
+    batchDirector.produce(999, &pc::DinnerDirector::liteDinner, dinners);
+    if (dinners.size() != 999) {
+        throw std::runtime_error("builder failed");
+    }
+    for (const auto& dinner : dinners) {
+        if (dinner.menu() != "bbq ribs") {
+            throw std::runtime_error("builder failed");
+        }
+    }
+
+    // A batch waits for its own slices only, so a pool task can produce one
+    // while the pool is still busy with that task
+    std::latch produced(1);
+    pool.submit([&batchDirector, &dinners, &produced]() {
+        batchDirector.produce(10, &pc::DinnerDirector::fullDinner, dinners);
+        produced.count_down();
+    });
+    produced.wait();
+    pool.wait();
+    if ((dinners.size() != 10) || (dinners.back().menu() != "shrimp cocktail;bbq ribs;ice cream")) {
+        throw std::runtime_error("builder failed");
+    }
+    batchDirector.produce(0, &pc::DinnerDirector::liteDinner, dinners);
+    if (!dinners.empty()) {
+        throw std::runtime_error("builder failed");
+    }
+
+    // The only worker produces a batch, the calling task runs every slice
+    patterns::concurrency::ThreadPool single(1);
+    pc::BatchDinnerDirector singleDirector(single, []() {
+        return std::make_unique<pc::BbqDinnerBuilder>();
+    });
+    std::latch singleProduced(1);
+    single.submit([&singleDirector, &dinners, &singleProduced]() {
+        singleDirector.produce(100, &pc::DinnerDirector::liteDinner, dinners);
+        singleProduced.count_down();
+    });
+    singleProduced.wait();
+    single.wait();
+    if ((dinners.size() != 100) || (dinners.front().menu() != "bbq ribs")) {
+        throw std::runtime_error("builder failed");
+    }
+
+    // A throwing recipe fails the batch on the caller and on the workers alike,
+    // only after every slice is done, and the builders start clean afterwards
+    std::atomic<int> entriesLeft{0};
+    for (auto* target : {&pool, &single}) {
+        pc::BatchDinnerDirector failing(*target, [&entriesLeft]() {
+            return std::make_unique<FailingDinnerBuilder>(entriesLeft);
+        });
+        entriesLeft = 500;
+        try {
+            failing.produce(1000, &pc::DinnerDirector::fullDinner, dinners);
+            throw std::logic_error("builder failed");
+        } catch (const std::runtime_error&) {
+        }
+        entriesLeft = 1000;
+        failing.produce(1000, &pc::DinnerDirector::fullDinner, dinners);
+        for (const auto& dinner : dinners) {
+            if (dinner.menu() != "shrimp cocktail;bbq ribs;ice cream") {
+                throw std::runtime_error("builder failed");
+            }
+        }
+    }
+}
+
+void menuExporterTest() {
+    pc::BbqDinnerBuilder bbqBuilder;
+    pc::DinnerDirector director(&bbqBuilder);
+    // Long items go out by reference, short ones through the staging buffer
+    const std::string platter(300, 'p');
+    std::vector<pc::UniqueDinner> dinners;
+    for (int i = 0; i < 3000; ++i) {
+        if (i % 3 == 0) {
+            director.fullDinner();
+        } else {
+            director.liteDinner();
+        }
+        dinners.push_back(bbqBuilder.getDinner());
+        if (i % 3 == 2) {
+            dinners.back()->add(platter);
+        }
+    }
+    dinners.push_back(std::make_unique<pc::DinnerMenu>());
+
+    // Interned names are stored followed by their separator and newline
+    const auto& table = pc::MenuItemTable::global();
+    const auto ribs = table.terminated(dinners.front()->items()[1], false);
+    if ((ribs != "bbq ribs;") || (table.terminated(dinners.front()->items()[1], true) != "bbq ribs\n")) {
+        throw std::runtime_error("menu exporter failed");
+    }
+
+    // Enough menus to fill the staging buffer and the writev batch several
+    // times, with the default threshold, gathering everything and copying everything
+    std::string expected;
+    for (const auto& dinner : dinners) {
+        expected += dinner->menu() + "\n";
+    }
+    const std::string path = uniqueTempPath("menu_exporter_test");
+    for (const std::size_t threshold : {pc::MenuExporter::defaultCopyThreshold, std::size_t(0), SIZE_MAX}) {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("menu exporter failed");
+        }
+        {
+            pc::MenuExporter exporter(fd, threshold);
+            for (const auto& dinner : dinners) {
+                exporter.write(*dinner);
+            }
+            exporter.flush();
+        }
+        ::close(fd);
+
+        std::ifstream in(path, std::ios::binary);
+        const std::string exported((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (exported != expected) {
+            throw std::runtime_error("menu exporter failed");
+        }
+    }
+    std::remove(path.c_str());
 }
 
 void proxyTest() {
@@ -114,6 +851,422 @@ void proxyTest() {
 
     ps::Proxy proxy1("proxy1", {"proxy"});
     clientFunc(proxy1, {});
+
+    if ((serviceA->request("menu") != "serviceA/menu") || (serviceA->request("") != "serviceA") || (proxy.request("menu") != "proxy/menu") ||
+        !proxy1.request("menu").empty()) {
+        throw std::runtime_error("proxy failed");
+    }
+
+    // Proxies sharing an allowlist all see a reload
+    auto allowlist = pp::makeCustomShared<ps::ReloadableAllowlist>(std::unordered_set<std::string>{"left"});
+    ps::Proxy left("left", allowlist);
+    ps::Proxy right("right", allowlist);
+    clientFunc(left, "left");
+    clientFunc(right, {});
+    allowlist->reload({"right", "other"});
+    clientFunc(left, {});
+    clientFunc(right, "right");
+    if (!right.allowlist()->allows("other") || right.allowlist()->allows("left")) {
+        throw std::runtime_error("proxy failed");
+    }
+
+    // Lazy proxies build the service once, on the first allowed request
+    std::atomic<int> built(0);
+    auto factory = [&built](const std::string& name) {
+        ++built;
+        return std::make_unique<ps::ServiceA>(name);
+    };
+    const ps::Proxy eager("left", allowlist, ps::Construction::Eager, factory);
+    const ps::Proxy denied("left", allowlist, ps::Construction::Lazy, factory);
+    const ps::Proxy lazy("right", allowlist, ps::Construction::Lazy, factory);
+    if ((built != 1) || !eager.constructed() || lazy.constructed()) {
+        throw std::runtime_error("proxy failed");
+    }
+    clientFunc(denied, {});
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&lazy]() {
+            if (lazy.request("menu") != "right/menu") {
+                throw std::logic_error("proxy failed");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if ((built != 2) || denied.constructed() || !lazy.constructed()) {
+        throw std::runtime_error("proxy failed");
+    }
+
+    // Or ahead of it in the background
+    const ps::Proxy prewarmed("right", allowlist, ps::Construction::Lazy, factory);
+    {
+        patterns::concurrency::ThreadPool pool(1);
+        prewarmed.prewarm(pool);
+        pool.wait();
+    }
+    if ((built != 3) || !prewarmed.constructed()) {
+        throw std::runtime_error("proxy failed");
+    }
+    clientFunc(prewarmed, "right");
+
+    // A factory failing during prewarm leaves the proxy for the first request to build
+    std::atomic<int> attempts(0);
+    const ps::Proxy flaky("right", allowlist, ps::Construction::Lazy, [&attempts](const std::string& name) {
+        if (++attempts == 1) {
+            throw std::runtime_error("service unavailable");
+        }
+        return std::make_unique<ps::ServiceA>(name);
+    });
+    {
+        patterns::concurrency::ThreadPool pool(1);
+        flaky.prewarm(pool);
+        pool.wait();
+    }
+    if ((attempts != 1) || flaky.constructed()) {
+        throw std::runtime_error("proxy failed");
+    }
+    clientFunc(flaky, "right");
+    if ((attempts != 2) || !flaky.constructed()) {
+        throw std::runtime_error("proxy failed");
+    }
+
+    std::unordered_set<std::string> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.insert("service" + std::to_string(i));
+    }
+    const ps::Allowlist large(names);
+    if ((large.size() != 1000) || !large.contains("service0") || !large.contains("service999") ||
+        large.contains("service1000") || large.contains("") || ps::Allowlist({}).contains("service0")) {
+        throw std::runtime_error("proxy failed");
+    }
+}
+
+// Answers like ServiceA and counts how often it was asked
+class CountingService final : public ps::Service {
+public:
+    mutable std::atomic<int> calls{0};
+
+    CountingService() : ps::Service("counting") { }
+
+    std::string request() const override {
+        return this->request(std::string());
+    }
+
+    std::string request(const std::string& query) const override {
+        ++this->calls;
+        return this->_name + "/" + query;
+    }
+};
+
+// Holds every request until released, so callers pile up behind the first
+class GatedService final : public ps::Service {
+public:
+    mutable std::atomic<int> calls{0};
+    std::atomic<bool> open{false};
+    bool fail = false;
+
+    GatedService() : ps::Service("gated") { }
+
+    std::string request() const override {
+        return this->request(std::string());
+    }
+
+    std::string request(const std::string& query) const override {
+        ++this->calls;
+        while (!this->open) {
+            std::this_thread::yield();
+        }
+        if (this->fail) {
+            throw std::runtime_error("backend down");
+        }
+        return this->_name + "/" + query;
+    }
+};
+
+void coalescingProxyTest() {
+    auto service = std::make_unique<GatedService>();
+    GatedService& backend = *service;
+    const ps::CoalescingProxy proxy("coalescing", std::move(service));
+
+    // Callers of one query share the call of the first, or its exception
+    for (const bool fail : {false, true}) {
+        backend.fail = fail;
+        backend.open = false;
+        const auto before = proxy.stats();
+        const std::string expected = fail ? "backend down" : "gated/menu";
+        std::vector<std::thread> threads;
+        std::atomic<int> matched(0);
+        for (int i = 0; i < 16; ++i) {
+            threads.emplace_back([&proxy, &expected, &matched]() {
+                try {
+                    matched += (proxy.request("menu") == expected) ? 1 : 0;
+                } catch (const std::runtime_error& e) {
+                    matched += (e.what() == expected) ? 1 : 0;
+                }
+            });
+        }
+        while ((proxy.stats().coalesced - before.coalesced) != 15) {
+            std::this_thread::yield();
+        }
+        backend.open = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if ((matched != 16) || ((proxy.stats().calls - before.calls) != 1)) {
+            throw std::runtime_error("coalescing proxy failed");
+        }
+    }
+
+    // Nothing is cached once the call is done
+    backend.fail = false;
+    const int calls = backend.calls;
+    if ((proxy.request("menu") != "gated/menu") || (proxy.request("other") != "gated/other") ||
+        (backend.calls != calls + 2)) {
+        throw std::runtime_error("coalescing proxy failed");
+    }
+}
+
+void rateLimitingProxyTest() {
+    // 10 tokens per second, bursts of 3
+    ps::TokenBucket bucket(10, 3);
+    const auto start = ps::TokenBucket::Clock::now();
+    for (int i = 0; i < 3; ++i) {
+        if (!bucket.tryTake(start)) {
+            throw std::runtime_error("rate limiting proxy failed");
+        }
+    }
+    if (bucket.tryTake(start) || !bucket.tryTake(start + std::chrono::milliseconds(100)) ||
+        bucket.tryTake(start + std::chrono::milliseconds(100))) {
+        throw std::runtime_error("rate limiting proxy failed");
+    }
+    // A long idle bucket holds no more than the burst
+    const auto later = start + std::chrono::seconds(10);
+    int taken = 0;
+    while (bucket.tryTake(later)) {
+        ++taken;
+    }
+    if (taken != 3) {
+        throw std::runtime_error("rate limiting proxy failed");
+    }
+    // Waiting callers are handed consecutive slots
+    if ((bucket.take(later) != later + std::chrono::milliseconds(100)) ||
+        (bucket.take(later) != later + std::chrono::milliseconds(200))) {
+        throw std::runtime_error("rate limiting proxy failed");
+    }
+
+    // Rates and bursts whose interval or window does not fit are refused
+    const double badRates[] = {0, -1, std::numeric_limits<double>::quiet_NaN(),
+        std::numeric_limits<double>::infinity(), 1e-12, 1e10};
+    // A limiter refuses them at construction rather than at its first request
+    auto refused = [](double rate, std::size_t burst) {
+        int threw = 0;
+        try {
+            ps::TokenBucket bad(rate, burst);
+        } catch (const std::runtime_error&) {
+            ++threw;
+        }
+        try {
+            ps::RateLimiter bad(rate, burst);
+        } catch (const std::runtime_error&) {
+            ++threw;
+        }
+        return threw == 2;
+    };
+    for (const double rate : badRates) {
+        if (!refused(rate, 1)) {
+            throw std::runtime_error("rate limiting proxy failed");
+        }
+    }
+    for (const std::size_t burst : {std::size_t(0), SIZE_MAX}) {
+        if (!refused(10, burst)) {
+            throw std::runtime_error("rate limiting proxy failed");
+        }
+    }
+
+    // Proxies of the same caller share a bucket, other callers have their own
+    auto limiter = pp::makeCustomShared<ps::RateLimiter>(0.001, 2);
+    const ps::RateLimitingProxy first("caller", std::make_unique<ps::ServiceA>("serviceA"), limiter);
+    const ps::RateLimitingProxy second("caller", std::make_unique<ps::ServiceA>("serviceA"), limiter);
+    const ps::RateLimitingProxy other("other", std::make_unique<ps::ServiceA>("serviceA"), limiter);
+    if ((first.request("menu") != "serviceA/menu") || (second.request() != "serviceA") ||
+        !first.request("menu").empty() || !second.request().empty() || (other.request() != "serviceA")) {
+        throw std::runtime_error("rate limiting proxy failed");
+    }
+
+    // Over the limit requests can wait for their turn instead
+    const ps::RateLimitingProxy waiting("waiting", std::make_unique<ps::ServiceA>("serviceA"),
+        pp::makeCustomShared<ps::RateLimiter>(100, 1), ps::OverLimit::Wait);
+    const auto waitStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        if (waiting.request() != "serviceA") {
+            throw std::runtime_error("rate limiting proxy failed");
+        }
+    }
+    if ((std::chrono::steady_clock::now() - waitStart) < std::chrono::milliseconds(19)) {
+        throw std::runtime_error("rate limiting proxy failed");
+    }
+}
+
+void cachingProxyTest() {
+    auto service = std::make_unique<CountingService>();
+    const CountingService& backend = *service;
+    // Two shards of two entries each
+    ps::CachingProxy proxy("cache", std::move(service), 4, std::chrono::milliseconds(200), 2);
+
+    for (int round = 0; round < 3; ++round) {
+        if ((proxy.request("a") != "counting/a") || (proxy.request("b") != "counting/b")) {
+            throw std::runtime_error("caching proxy failed");
+        }
+    }
+    auto stats = proxy.stats();
+    if ((backend.calls != 2) || (stats.hits != 4) || (stats.misses != 2) || (stats.evictions != 0)) {
+        throw std::runtime_error("caching proxy failed");
+    }
+
+    // Far more queries than fit, the least recently used ones get evicted
+    for (int i = 0; i < 100; ++i) {
+        proxy.request(std::to_string(i));
+    }
+    stats = proxy.stats();
+    if ((stats.evictions < 96) || ((stats.misses - stats.evictions) > 4)) {
+        throw std::runtime_error("caching proxy failed");
+    }
+
+    // Expired results are fetched again
+    proxy.request("fresh");
+    const int calls = backend.calls;
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    if ((proxy.request("fresh") != "counting/fresh") || (backend.calls != calls + 1)) {
+        throw std::runtime_error("caching proxy failed");
+    }
+
+    // Concurrent callers over a working set that fits
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&proxy, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                const std::string query = std::to_string((i + t) % 3);
+                if (proxy.request(query) != "counting/" + query) {
+                    throw std::logic_error("caching proxy failed");
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    stats = proxy.stats();
+    if ((stats.hits + stats.misses) != (6 + 100 + 2 + 8000)) {
+        throw std::runtime_error("caching proxy failed");
+    }
+
+    // Shard sizes add up to the capacity, also with fewer entries than shards
+    for (std::size_t capacity : {17, 3}) {
+        ps::CachingProxy bounded("bounded", std::make_unique<CountingService>(), capacity,
+            std::chrono::seconds(10), 16);
+        for (int i = 0; i < 1000; ++i) {
+            bounded.request(std::to_string(i));
+            if (bounded.size() > capacity) {
+                throw std::runtime_error("caching proxy failed");
+            }
+        }
+        if (bounded.size() != capacity) {
+            throw std::runtime_error("caching proxy failed");
+        }
+    }
+}
+
+// Waits on the executor timer instead of blocking a thread
+class SleepyService final : public ps::Service {
+public:
+    SleepyService() : ps::Service("sleepy") { }
+
+    std::string request() const override {
+        return this->_name;
+    }
+
+    patterns::concurrency::Task<std::string> asyncRequest(std::string query,
+        patterns::concurrency::Executor& executor) const override {
+        co_await executor.sleepFor(std::chrono::milliseconds(10));
+        co_return this->_name + "/" + query;
+    }
+};
+
+patterns::concurrency::Task<void> fetchInto(const ps::Service& service, patterns::concurrency::Executor& executor,
+    std::string query, std::string& out, std::latch& done) {
+    out = co_await service.asyncRequest(std::move(query), executor);
+    done.count_down();
+}
+
+void asyncRequestTest() {
+    using patterns::concurrency::syncWait;
+    patterns::concurrency::Executor executor(2);
+
+    const ps::ServiceA serviceA("serviceA");
+    const ps::Proxy allowed("proxy", {"proxy"});
+    const ps::Proxy denied("proxy1", {"proxy"});
+    if ((syncWait(serviceA.asyncRequest("menu", executor)) != "serviceA/menu") ||
+        (syncWait(allowed.asyncRequest("", executor)) != "proxy") ||
+        !syncWait(denied.asyncRequest("menu", executor)).empty()) {
+        throw std::runtime_error("async request failed");
+    }
+
+    // Blocking services run on the executor, exceptions reach the awaiting caller
+    const CountingService counting;
+    if ((syncWait(counting.asyncRequest("menu", executor)) != "counting/menu") || (counting.calls != 1)) {
+        throw std::runtime_error("async request failed");
+    }
+    GatedService failing;
+    failing.fail = true;
+    failing.open = true;
+    try {
+        syncWait(failing.asyncRequest("menu", executor));
+        throw std::logic_error("async request failed");
+    } catch (const std::runtime_error& e) {
+        if (std::string(e.what()) != "backend down") {
+            throw std::runtime_error("async request failed");
+        }
+    }
+
+    // Far more outstanding requests than threads, all waiting at once.
+    // The executor goes first, so coroutines finishing up never see a dead latch.
+    constexpr int outstanding = 1000;
+    const SleepyService sleepy;
+    std::vector<std::string> responses(outstanding);
+    std::latch done(outstanding);
+    {
+        patterns::concurrency::Executor twoThreads(2);
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < outstanding; ++i) {
+            twoThreads.spawn(fetchInto(sleepy, twoThreads, std::to_string(i), responses[i], done));
+        }
+        done.wait();
+        if ((std::chrono::steady_clock::now() - start) > std::chrono::seconds(2)) {
+            throw std::runtime_error("async request failed");
+        }
+    }
+    for (int i = 0; i < outstanding; ++i) {
+        if (responses[i] != "sleepy/" + std::to_string(i)) {
+            throw std::runtime_error("async request failed");
+        }
+    }
+
+    // Tasks still queued when the executor goes may post timers
+    std::atomic<bool> posted{false};
+    {
+        patterns::concurrency::Executor shutdown(1);
+        shutdown.post([]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+        shutdown.post([&shutdown, &posted]() {
+            shutdown.postAt(patterns::concurrency::Executor::Clock::now(), []() { });
+            posted = true;
+        });
+    }
+    if (!posted) {
+        throw std::runtime_error("async request failed");
+    }
 }
 
 void uniquePtrTest() {
@@ -159,6 +1312,73 @@ void uniquePtrTest() {
     }
 }
 
+// Stateless deleter handing objects back to a fixed size pool
+struct PoolDeleter {
+    static std::vector<int*> pool;
+    void operator()(int* ptr) const {
+        pool.push_back(ptr);
+    }
+};
+
+std::vector<int*> PoolDeleter::pool;
+
+void uniquePtrDeleterTest() {
+    static_assert(sizeof(pp::CustomUniquePtr<int>) == sizeof(int*), "unique pointer must be one word");
+    static_assert(sizeof(pp::CustomUniquePtr<int, PoolDeleter>) == sizeof(int*), "unique pointer must be one word");
+    static_assert(sizeof(pp::CustomUniquePtr<int[]>) == sizeof(int*), "unique pointer must be one word");
+
+    // Mutable access, release and reset
+    pp::CustomUniquePtr<int> uniquePtr(new int(1));
+    *uniquePtr = 2;
+    int* raw = uniquePtr.release();
+    if (uniquePtr || (*raw != 2)) {
+        throw std::runtime_error("unique pointer deleter failed");
+    }
+    uniquePtr.reset(raw);
+    uniquePtr.reset(new int(3));
+    if (*uniquePtr != 3) {
+        throw std::runtime_error("unique pointer deleter failed");
+    }
+
+    // Stateless custom deleter
+    int pooled[2] = {0, 0};
+    {
+        pp::CustomUniquePtr<int, PoolDeleter> pooledPtr(&pooled[0]);
+        pp::CustomUniquePtr<int, PoolDeleter> pooledPtr1(&pooled[1]);
+        pooledPtr1 = std::move(pooledPtr);
+        if ((PoolDeleter::pool.size() != 1) || (PoolDeleter::pool[0] != &pooled[1])) {
+            throw std::runtime_error("unique pointer deleter failed");
+        }
+    }
+    if ((PoolDeleter::pool.size() != 2) || (PoolDeleter::pool[1] != &pooled[0])) {
+        throw std::runtime_error("unique pointer deleter failed");
+    }
+
+    // Stateful deleter
+    int released = 0;
+    auto counter = [&released](int* ptr) {
+        ++released;
+        delete ptr;
+    };
+    {
+        pp::CustomUniquePtr<int, decltype(counter)> countedPtr(new int(4), counter);
+        auto countedPtr1 = std::move(countedPtr);
+    }
+    if (released != 1) {
+        throw std::runtime_error("unique pointer deleter failed");
+    }
+
+    // Array
+    pp::CustomUniquePtr<double[]> buffer(new double[3]);
+    for (int i = 0; i < 3; ++i) {
+        buffer[i] = i * 0.5;
+    }
+    auto buffer1 = std::move(buffer);
+    if (buffer || (buffer1[2] != 1.0)) {
+        throw std::runtime_error("unique pointer deleter failed");
+    }
+}
+
 void sharedPtrTest() {
     // Ctor
     pp::CustomSharedPtr<int> sharedPtr(new int(5));
@@ -277,10 +1497,255 @@ void sharedPtrTest() {
     }
 }
 
+void sharedPtrPolicyTest() {
+    // Non atomic policy
+    pp::LocalSharedPtr<int> localPtr(new int(7));
+    pp::LocalSharedPtr<int> localPtr1;
+    localPtr1 = localPtr;
+    if ((localPtr.useCount() != 2) || (*localPtr1 != 7) || localPtr.unique()) {
+        throw std::runtime_error("shared pointer policy failed");
+    }
+    localPtr1.release();
+    if ((localPtr.useCount() != 1) || !localPtr.unique() || localPtr1.unique()) {
+        throw std::runtime_error("shared pointer policy failed");
+    }
+
+    // Atomic policy shared between threads
+    pp::CustomSharedPtr<int, pp::AtomicRefCount> atomicPtr(new int(9));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&atomicPtr]() {
+            for (int j = 0; j < 10000; ++j) {
+                auto copy = atomicPtr;
+                if (*copy != 9) {
+                    throw std::runtime_error("shared pointer policy failed");
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    if ((atomicPtr.useCount() != 1) || !atomicPtr.unique()) {
+        throw std::runtime_error("shared pointer policy failed");
+    }
+
+}
+
+// Counts the blocks handed out to allocateCustomShared
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    int* allocations;
+
+    explicit CountingAllocator(int* allocations) : allocations(allocations) { }
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : allocations(other.allocations) { }
+
+    T* allocate(std::size_t n) {
+        ++(*allocations);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        --(*allocations);
+        std::allocator<T>().deallocate(p, n);
+    }
+};
+
+void makeSharedTest() {
+    auto sharedPtr = pp::makeCustomShared<std::string>(3, 'a');
+    auto sharedPtr1 = sharedPtr;
+    if ((*sharedPtr1 != "aaa") || (sharedPtr.useCount() != 2)) {
+        throw std::runtime_error("make shared failed");
+    }
+    sharedPtr.release();
+    if (sharedPtr || (sharedPtr1.useCount() != 1) || (sharedPtr1->size() != 3)) {
+        throw std::runtime_error("make shared failed");
+    }
+
+    int allocations = 0;
+    {
+        auto allocated = pp::allocateCustomShared<double>(CountingAllocator<double>(&allocations), 2.5);
+        auto copy = allocated;
+        if ((allocations != 1) || (*copy != 2.5)) {
+            throw std::runtime_error("allocate shared failed");
+        }
+    }
+    if (allocations != 0) {
+        throw std::runtime_error("allocate shared failed");
+    }
+}
+
+void weakPtrTest() {
+    // Lock while alive, expire after the last owner is gone
+    pp::CustomSharedPtr<int> sharedPtr(new int(4));
+    pp::CustomWeakPtr<int> weakPtr(sharedPtr);
+    auto locked = weakPtr.lock();
+    if (!locked || (*locked != 4) || (weakPtr.useCount() != 2)) {
+        throw std::runtime_error("weak pointer failed");
+    }
+    locked.release();
+    sharedPtr.release();
+    if (!weakPtr.expired() || weakPtr.lock()) {
+        throw std::runtime_error("weak pointer failed");
+    }
+
+    // Inline block outlives the object while weak pointers remain
+    int allocations = 0;
+    auto allocated = pp::allocateCustomShared<int>(CountingAllocator<int>(&allocations), 1);
+    pp::CustomWeakPtr<int> weakPtr1(allocated);
+    auto weakPtr2 = weakPtr1;
+    allocated.release();
+    if ((allocations != 1) || !weakPtr2.expired()) {
+        throw std::runtime_error("weak pointer failed");
+    }
+    weakPtr1.release();
+    weakPtr2.release();
+    if (allocations != 0) {
+        throw std::runtime_error("weak pointer failed");
+    }
+
+    // Lock racing with the release of the last owner
+    for (int round = 0; round < 100; ++round) {
+        auto owner = pp::makeCustomShared<int>(round);
+        pp::CustomWeakPtr<int> observer(owner);
+        std::thread locker([&observer, round]() {
+            for (int i = 0; i < 100; ++i) {
+                auto ptr = observer.lock();
+                if (ptr && (*ptr != round)) {
+                    throw std::runtime_error("weak pointer failed");
+                }
+            }
+        });
+        owner.release();
+        locker.join();
+        if (!observer.expired()) {
+            throw std::runtime_error("weak pointer failed");
+        }
+    }
+}
+
+class Counted final : public pp::RefCounted<Counted> {
+public:
+    static std::atomic<int> alive;
+    int value;
+
+    explicit Counted(int value) : value(value) {
+        ++alive;
+    }
+    ~Counted() {
+        --alive;
+    }
+};
+
+std::atomic<int> Counted::alive{0};
+
+class LocalCounted final : public pp::RefCounted<LocalCounted, pp::NonAtomicRefCount> { };
+
+void intrusivePtrTest() {
+    static_assert(sizeof(pp::CustomIntrusivePtr<Counted>) == sizeof(Counted*),
+        "intrusive pointer must be one word");
+
+    {
+        auto intrusivePtr = pp::makeCustomIntrusive<Counted>(6);
+        auto intrusivePtr1 = intrusivePtr;
+        pp::CustomIntrusivePtr<Counted> intrusivePtr2(intrusivePtr.get());
+        if ((intrusivePtr1->value != 6) || (intrusivePtr.useCount() != 3)) {
+            throw std::runtime_error("intrusive pointer failed");
+        }
+
+        intrusivePtr1 = intrusivePtr2;
+        auto intrusivePtr3 = std::move(intrusivePtr2);
+        if (intrusivePtr2 || (intrusivePtr3.useCount() != 3)) {
+            throw std::runtime_error("intrusive pointer failed");
+        }
+
+        intrusivePtr.release();
+        intrusivePtr1.release();
+        if ((Counted::alive != 1) || ((*intrusivePtr3).value != 6)) {
+            throw std::runtime_error("intrusive pointer failed");
+        }
+    }
+    if (Counted::alive != 0) {
+        throw std::runtime_error("intrusive pointer failed");
+    }
+
+    auto localPtr = pp::makeCustomIntrusive<LocalCounted>();
+    std::vector<pp::CustomIntrusivePtr<LocalCounted>> localPtrs(3, localPtr);
+    if (localPtr.useCount() != 4) {
+        throw std::runtime_error("intrusive pointer failed");
+    }
+}
+
+void atomicSharedPtrTest() {
+    pp::AtomicCustomSharedPtr<int> atomicPtr(pp::makeCustomShared<int>(1));
+    auto loaded = atomicPtr.load();
+    if (!loaded || (*loaded != 1) || (loaded.useCount() != 2)) {
+        throw std::runtime_error("atomic shared pointer failed");
+    }
+
+    auto previous = atomicPtr.exchange(pp::makeCustomShared<int>(2));
+    if ((previous.get() != loaded.get()) || (*atomicPtr.load() != 2)) {
+        throw std::runtime_error("atomic shared pointer failed");
+    }
+
+    // Stale expected value fails and gets refreshed
+    if (atomicPtr.compareExchange(loaded, pp::makeCustomShared<int>(3)) || (*loaded != 2)) {
+        throw std::runtime_error("atomic shared pointer failed");
+    }
+    if (!atomicPtr.compareExchange(loaded, pp::makeCustomShared<int>(3)) || (*atomicPtr.load() != 3)) {
+        throw std::runtime_error("atomic shared pointer failed");
+    }
+    atomicPtr.store(pp::CustomSharedPtr<int>());
+    if (atomicPtr.load()) {
+        throw std::runtime_error("atomic shared pointer failed");
+    }
+
+    // Readers racing with writers, every object must be freed exactly once
+    {
+        pp::AtomicCustomSharedPtr<Counted> config(pp::CustomSharedPtr<Counted>(new Counted(0)));
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&config]() {
+                int last = 0;
+                for (int j = 0; j < 20000; ++j) {
+                    auto snapshot = config.load();
+                    if (snapshot->value < last) {
+                        throw std::runtime_error("atomic shared pointer failed");
+                    }
+                    last = snapshot->value;
+                }
+            });
+        }
+        threads.emplace_back([&config]() {
+            for (int j = 1; j <= 2000; ++j) {
+                config.store(pp::CustomSharedPtr<Counted>(new Counted(j)));
+            }
+        });
+        for (auto& t : threads) {
+            t.join();
+        }
+        if (config.load()->value != 2000) {
+            throw std::runtime_error("atomic shared pointer failed");
+        }
+    }
+    if (Counted::alive != 0) {
+        throw std::runtime_error("atomic shared pointer failed");
+    }
+}
+
 void pointersTest() {
     uniquePtrTest();
+    uniquePtrDeleterTest();
 
     sharedPtrTest();
+    sharedPtrPolicyTest();
+    makeSharedTest();
+    weakPtrTest();
+    intrusivePtrTest();
+    atomicSharedPtrTest();
 }
 
 void adapterTest() {
@@ -313,14 +1778,24 @@ void adapterTest() {
 
 int main() {
     singletonTest();
+    singletonRegistryTest();
     factoryMethodTest();
+    shapeRegistryTest();
+    shapeVariantTest();
+    objectPoolTest();
     prototypeTest();
+    prototypeSnapshotTest();
     builderTest();
+    menuExporterTest();
 
     pointersTest();
 
     adapterTest();
     proxyTest();
+    cachingProxyTest();
+    coalescingProxyTest();
+    rateLimitingProxyTest();
+    asyncRequestTest();
 
     std::cout << "unit tests pass" << std::endl;
 
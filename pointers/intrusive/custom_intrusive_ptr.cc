@@ -0,0 +1,5 @@
+#include "custom_intrusive_ptr.h"
+
+namespace patterns::pointers {
+
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <utility>
+
+#include "../shared/ref_count_policy.h"
+
+namespace patterns::pointers {
+
+// Mix-in storing the reference count inside the object itself.
+// Derived is the most derived type deleted on the last release,
+// so it has to be either final or have a virtual destructor.
+template <typename Derived, typename RefCount = AtomicRefCount>
+class RefCounted {
+private:
+    mutable typename RefCount::Counter refs;
+
+protected:
+    RefCounted() : refs(0) { }
+    // A copy of the object starts unshared
+    RefCounted(const RefCounted&) : refs(0) { }
+    RefCounted& operator=(const RefCounted&) {
+        return *this;
+    }
+    ~RefCounted() = default;
+
+public:
+    void addRef() const {
+        RefCount::increment(refs);
+    }
+
+    void releaseRef() const {
+        if (RefCount::decrement(refs)) {
+            delete static_cast<const Derived*>(this);
+        }
+    }
+
+    long refCount() const {
+        return RefCount::load(refs);
+    }
+};
+
+// Single word shared pointer for types deriving from RefCounted
+template <typename T>
+class CustomIntrusivePtr final {
+private:
+    T* ptr = nullptr;
+
+public:
+    explicit CustomIntrusivePtr(T* ptr = nullptr) : ptr(ptr) {
+        if (ptr != nullptr) {
+            ptr->addRef();
+        }
+    }
+
+    // Copyable
+    CustomIntrusivePtr(const CustomIntrusivePtr& other) : ptr(other.ptr) {
+        if (ptr != nullptr) {
+            ptr->addRef();
+        }
+    }
+
+    CustomIntrusivePtr& operator=(const CustomIntrusivePtr& other) {
+        if (this != &other) {
+            // Take the new reference first in case both point at the same object
+            if (other.ptr != nullptr) {
+                other.ptr->addRef();
+            }
+            release();
+            ptr = other.ptr;
+        }
+        return *this;
+    }
+
+    // Movable
+    CustomIntrusivePtr(CustomIntrusivePtr&& other) noexcept : ptr(other.ptr) {
+        other.ptr = nullptr;
+    }
+
+    CustomIntrusivePtr& operator=(CustomIntrusivePtr&& other) noexcept {
+        if (this != &other) {
+            release();
+            ptr = other.ptr;
+            other.ptr = nullptr;
+        }
+        return *this;
+    }
+
+    ~CustomIntrusivePtr() {
+        release();
+    }
+
+    operator bool() const {
+        return ptr != nullptr;
+    }
+
+    T& operator *() const {
+        return *ptr;
+    }
+
+    T* operator ->() const {
+        return ptr;
+    }
+
+    T* get() const {
+        return ptr;
+    }
+
+    long useCount() const {
+        return (ptr != nullptr) ? ptr->refCount() : 0;
+    }
+
+    void release() {
+        if (ptr != nullptr) {
+            ptr->releaseRef();
+        }
+        ptr = nullptr;
+    }
+};
+
+template <typename T, typename... Args>
+CustomIntrusivePtr<T> makeCustomIntrusive(Args&&... args) {
+    return CustomIntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+#include "custom_shared_ptr.h"
+
+namespace patterns::pointers {
+
+// Atomic holder of a CustomSharedPtr for read mostly data swapped as a whole.
+//
+// Uses split reference counting: the held control block pointer and a small
+// local count are packed into one word. A reader bumps the local count with
+// a single fetch_add, which pins the block, takes a real strong reference and
+// then hands the local one back. A writer that swaps the block out moves the
+// outstanding local count into the strong count before dropping the holder's
+// own reference, so readers caught in between never see a freed block.
+// Neither side takes a lock.
+template <typename T>
+class AtomicCustomSharedPtr final {
+private:
+    using Shared = CustomSharedPtr<T, AtomicRefCount>;
+    using Block = ControlBlock<AtomicRefCount>;
+    using Word = std::uintptr_t;
+
+    // x86-64 and aarch64 user space pointers fit in the low 48 bits,
+    // leaving 16 bits for readers in flight at the same time
+    static constexpr int pointerBits = 48;
+    static constexpr Word localOne = Word(1) << pointerBits;
+    static constexpr Word pointerMask = localOne - 1;
+
+    static_assert(sizeof(Word) == 8, "split reference counting needs 64 bit pointers");
+
+    mutable std::atomic<Word> word;
+
+    static Block* blockOf(Word w) {
+        return reinterpret_cast<Block*>(w & pointerMask);
+    }
+
+    static Word localOf(Word w) {
+        return w >> pointerBits;
+    }
+
+    // Takes over the strong reference held by desired
+    static Word pack(Shared& desired) {
+        const Word w = reinterpret_cast<Word>(desired.block);
+        assert((w & ~pointerMask) == 0);
+        desired.ptr = nullptr;
+        desired.block = nullptr;
+        return w;
+    }
+
+    static Shared adopt(Block* block) {
+        if (block == nullptr) {
+            return Shared();
+        }
+        return Shared(static_cast<T*>(block->managedObject()), block);
+    }
+
+    // Turns a word removed from the holder back into an owning pointer,
+    // folding in local references of readers still in flight
+    static Shared unpack(Word w) {
+        Block* block = blockOf(w);
+        if ((block != nullptr) && (localOf(w) != 0)) {
+            block->strong.fetch_add(static_cast<long>(localOf(w)), std::memory_order_relaxed);
+        }
+        return adopt(block);
+    }
+
+public:
+    AtomicCustomSharedPtr() : word(0) { }
+
+    explicit AtomicCustomSharedPtr(Shared desired) : word(pack(desired)) { }
+
+    AtomicCustomSharedPtr(const AtomicCustomSharedPtr&) = delete;
+    AtomicCustomSharedPtr& operator=(const AtomicCustomSharedPtr&) = delete;
+
+    ~AtomicCustomSharedPtr() {
+        unpack(word.exchange(0, std::memory_order_acquire));
+    }
+
+    Shared load() const {
+        const Word pinned = word.fetch_add(localOne, std::memory_order_acquire);
+        Block* block = blockOf(pinned);
+        if (block != nullptr) {
+            AtomicRefCount::increment(block->strong);
+        }
+
+        // Give the local reference back, unless a writer already moved it
+        // into the strong count
+        Word current = word.load(std::memory_order_relaxed);
+        while (true) {
+            if ((blockOf(current) != block) || (localOf(current) == 0)) {
+                if (block != nullptr) {
+                    block->releaseStrong();
+                }
+                break;
+            }
+            if (word.compare_exchange_weak(current, current - localOne,
+                    std::memory_order_relaxed, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        return adopt(block);
+    }
+
+    void store(Shared desired) {
+        exchange(std::move(desired));
+    }
+
+    Shared exchange(Shared desired) {
+        const Word next = pack(desired);
+        return unpack(word.exchange(next, std::memory_order_acq_rel));
+    }
+
+    // Replaces the held pointer with desired if it still owns the same object as
+    // expected. Otherwise loads the current value into expected.
+    bool compareExchange(Shared& expected, Shared desired) {
+        Word current = word.load(std::memory_order_relaxed);
+        while (blockOf(current) == expected.block) {
+            const Word next = reinterpret_cast<Word>(desired.block);
+            if (word.compare_exchange_weak(current, next,
+                    std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                pack(desired);
+                unpack(current);
+                return true;
+            }
+        }
+        expected = load();
+        return false;
+    }
+};
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace patterns::pointers {
+
+// Bookkeeping shared by every CustomSharedPtr and CustomWeakPtr of the same object.
+// The object lives while strong > 0. The block lives while weak > 0, where all
+// strong owners together hold a single weak reference.
+// The concrete block decides how the object and the block itself are freed.
+template <typename RefCount>
+class ControlBlock {
+public:
+    typename RefCount::Counter strong;
+    typename RefCount::Counter weak;
+
+    ControlBlock() : strong(1), weak(1) { }
+    virtual ~ControlBlock() = default;
+
+    void releaseStrong() noexcept {
+        if (RefCount::decrement(strong)) {
+            destroyObject();
+            releaseWeak();
+        }
+    }
+
+    void releaseWeak() noexcept {
+        if (RefCount::decrement(weak)) {
+            destroyBlock();
+        }
+    }
+
+    // Managed object while strong > 0
+    virtual void* managedObject() noexcept = 0;
+    // Destroys the managed object, called when the last strong owner is gone
+    virtual void destroyObject() noexcept = 0;
+    // Frees the block memory, called once the last weak reference is gone
+    virtual void destroyBlock() noexcept = 0;
+};
+
+// Block for an object allocated separately by the caller
+template <typename T, typename RefCount>
+class PointerControlBlock final : public ControlBlock<RefCount> {
+private:
+    T* ptr;
+
+public:
+    explicit PointerControlBlock(T* ptr) : ptr(ptr) { }
+
+    void* managedObject() noexcept override {
+        return ptr;
+    }
+
+    void destroyObject() noexcept override {
+        delete ptr;
+        ptr = nullptr;
+    }
+
+    void destroyBlock() noexcept override {
+        delete this;
+    }
+};
+
+// Block holding the object inline, so object and counts share one allocation
+template <typename T, typename RefCount, typename Alloc>
+class InplaceControlBlock final : public ControlBlock<RefCount> {
+private:
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<InplaceControlBlock>;
+    using BlockTraits = std::allocator_traits<BlockAlloc>;
+
+    BlockAlloc alloc;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    explicit InplaceControlBlock(const Alloc& alloc) : alloc(alloc) { }
+
+public:
+    T* object() {
+        return reinterpret_cast<T*>(storage);
+    }
+
+    void* managedObject() noexcept override {
+        return object();
+    }
+
+    void destroyObject() noexcept override {
+        object()->~T();
+    }
+
+    void destroyBlock() noexcept override {
+        BlockAlloc blockAlloc(std::move(alloc));
+        this->~InplaceControlBlock();
+        BlockTraits::deallocate(blockAlloc, this, 1);
+    }
+
+    // Allocates a block with the given allocator and constructs T inside it
+    template <typename... Args>
+    static InplaceControlBlock* create(const Alloc& alloc, Args&&... args) {
+        BlockAlloc blockAlloc(alloc);
+        InplaceControlBlock* block = BlockTraits::allocate(blockAlloc, 1);
+        ::new (static_cast<void*>(block)) InplaceControlBlock(alloc);
+        try {
+            ::new (static_cast<void*>(block->storage)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            block->destroyBlock();
+            throw;
+        }
+        return block;
+    }
+};
+
+}
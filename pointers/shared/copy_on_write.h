@@ -0,0 +1,58 @@
+#pragma once
+
+#include <utility>
+
+#include "custom_shared_ptr.h"
+
+namespace patterns::pointers {
+
+// Value of T shared between copies until one of them is modified.
+// Copies only bump a reference count; the first write through a shared
+// copy detaches it onto its own payload.
+template <typename T>
+class CopyOnWrite final {
+private:
+    CustomSharedPtr<T> payload;
+
+    bool unique() const {
+        return payload.unique();
+    }
+
+public:
+    explicit CopyOnWrite(T value) : payload(makeCustomShared<T>(std::move(value))) { }
+
+    const T& get() const {
+        return *payload;
+    }
+
+    const T& operator *() const {
+        return *payload;
+    }
+
+    const T* operator ->() const {
+        return payload.get();
+    }
+
+    // Writable access, copies the payload first if it is shared
+    T& mutate() {
+        if (!unique()) {
+            payload = makeCustomShared<T>(*payload);
+        }
+        return *payload;
+    }
+
+    // Replaces the value without copying a shared payload first
+    void assign(T value) {
+        if (unique()) {
+            *payload = std::move(value);
+        } else {
+            payload = makeCustomShared<T>(std::move(value));
+        }
+    }
+
+    bool sharesWith(const CopyOnWrite& other) const {
+        return payload.get() == other.payload.get();
+    }
+};
+
+}
@@ -1,50 +1,88 @@
 #pragma once
 
+#include <memory>
+#include <utility>
+
+#include "control_block.h"
+#include "ref_count_policy.h"
+
 namespace patterns::pointers {
 
+// Defined in custom_weak_ptr.h
+template <typename T, typename RefCount = AtomicRefCount>
+class CustomWeakPtr;
+
+// Defined in atomic_custom_shared_ptr.h
 template <typename T>
+class AtomicCustomSharedPtr;
+
+template <typename T, typename RefCount = AtomicRefCount>
 class CustomSharedPtr final {
 private:
+    using Block = ControlBlock<RefCount>;
+
     T *ptr;
-    int* count;
-    
+    Block* block;
+
+    // Adopts a block whose strong count already accounts for this owner
+    CustomSharedPtr(T* ptr, Block* block) : ptr(ptr), block(block) { }
+
+    static Block* makeBlock(T* ptr) {
+        if (ptr == nullptr) {
+            return nullptr;
+        }
+        try {
+            return new PointerControlBlock<T, RefCount>(ptr);
+        } catch (...) {
+            delete ptr;
+            throw;
+        }
+    }
+
+    template <typename U, typename R, typename Alloc, typename... Args>
+    friend CustomSharedPtr<U, R> allocateCustomShared(const Alloc& alloc, Args&&... args);
+    friend class CustomWeakPtr<T, RefCount>;
+    friend class AtomicCustomSharedPtr<T>;
+
 public:
-    explicit CustomSharedPtr(T *ptr) : ptr(ptr), count(new int(1)) { }
+    // Two allocations: the object and a separate control block.
+    // Prefer makeCustomShared which needs a single one.
+    explicit CustomSharedPtr(T *ptr = nullptr) : ptr(ptr), block(makeBlock(ptr)) { }
 
     // Copyable
-    CustomSharedPtr(const CustomSharedPtr& other) : ptr(other.ptr), count(other.count) {
+    CustomSharedPtr(const CustomSharedPtr& other) : ptr(other.ptr), block(other.block) {
         if (ptr != nullptr) {
-            ++(*count);
+            RefCount::increment(block->strong);
         }
     }
 
     CustomSharedPtr& operator=(const CustomSharedPtr& other) {
-        if (this != other) {
+        if (this != &other) {
             release();
             ptr = other.ptr;
-            count = other.count;
+            block = other.block;
             if (ptr != nullptr) {
-                ++(*count);
+                RefCount::increment(block->strong);
             }
         }
         return *this;
     }
 
     // Movable
-    CustomSharedPtr(CustomSharedPtr&& other) noexcept : ptr(other.ptr), count(other.count) {
+    CustomSharedPtr(CustomSharedPtr&& other) noexcept : ptr(other.ptr), block(other.block) {
         other.ptr = nullptr;
-        other.count = nullptr;
+        other.block = nullptr;
     }
 
     CustomSharedPtr& operator=(CustomSharedPtr&& other) noexcept {
         if (this != &other) {
-            release(ptr);
+            release();
 
             ptr = other.ptr;
-            count = other.count;
-        
+            block = other.block;
+
             other.ptr = nullptr;
-            other.count = nullptr;
+            other.block = nullptr;
         }
         return *this;
     }
@@ -65,17 +103,44 @@ public:
         return ptr;
     }
 
+    T* get() const {
+        return ptr;
+    }
+
+    long useCount() const {
+        return (block != nullptr) ? RefCount::load(block->strong) : 0;
+    }
+
+    // Sole owner, safe to modify the object in place when true
+    bool unique() const {
+        return (block != nullptr) && (RefCount::loadAcquire(block->strong) == 1);
+    }
+
     void release() {
         if (ptr != nullptr) {
-            --(*count);
-            if (*count == 0) {
-                delete ptr;
-                delete count;
-            }
+            block->releaseStrong();
         }
         ptr = nullptr;
-        count = nullptr;
+        block = nullptr;
     }
 };
 
-}
\ No newline at end of file
+template <typename T>
+using LocalSharedPtr = CustomSharedPtr<T, NonAtomicRefCount>;
+
+// Single allocation holding both the object and its control block,
+// obtained from the given allocator
+template <typename T, typename RefCount = AtomicRefCount, typename Alloc, typename... Args>
+CustomSharedPtr<T, RefCount> allocateCustomShared(const Alloc& alloc, Args&&... args) {
+    using Block = InplaceControlBlock<T, RefCount, Alloc>;
+    Block* block = Block::create(alloc, std::forward<Args>(args)...);
+    return CustomSharedPtr<T, RefCount>(block->object(), block);
+}
+
+// Single allocation holding both the object and its control block
+template <typename T, typename RefCount = AtomicRefCount, typename... Args>
+CustomSharedPtr<T, RefCount> makeCustomShared(Args&&... args) {
+    return allocateCustomShared<T, RefCount>(std::allocator<T>(), std::forward<Args>(args)...);
+}
+
+}
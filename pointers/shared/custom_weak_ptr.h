@@ -0,0 +1,97 @@
+#pragma once
+
+#include "custom_shared_ptr.h"
+
+namespace patterns::pointers {
+
+// Non owning observer of an object managed by CustomSharedPtr.
+// Keeps the control block alive but not the object itself.
+template <typename T, typename RefCount>
+class CustomWeakPtr final {
+private:
+    using Block = ControlBlock<RefCount>;
+
+    T* ptr = nullptr;
+    Block* block = nullptr;
+
+    void acquire() {
+        if (block != nullptr) {
+            RefCount::increment(block->weak);
+        }
+    }
+
+public:
+    CustomWeakPtr() = default;
+
+    CustomWeakPtr(const CustomSharedPtr<T, RefCount>& shared) : ptr(shared.ptr), block(shared.block) {
+        acquire();
+    }
+
+    // Copyable
+    CustomWeakPtr(const CustomWeakPtr& other) : ptr(other.ptr), block(other.block) {
+        acquire();
+    }
+
+    CustomWeakPtr& operator=(const CustomWeakPtr& other) {
+        if (this != &other) {
+            release();
+            ptr = other.ptr;
+            block = other.block;
+            acquire();
+        }
+        return *this;
+    }
+
+    // Movable
+    CustomWeakPtr(CustomWeakPtr&& other) noexcept : ptr(other.ptr), block(other.block) {
+        other.ptr = nullptr;
+        other.block = nullptr;
+    }
+
+    CustomWeakPtr& operator=(CustomWeakPtr&& other) noexcept {
+        if (this != &other) {
+            release();
+
+            ptr = other.ptr;
+            block = other.block;
+
+            other.ptr = nullptr;
+            other.block = nullptr;
+        }
+        return *this;
+    }
+
+    ~CustomWeakPtr() {
+        release();
+    }
+
+    long useCount() const {
+        return (block != nullptr) ? RefCount::load(block->strong) : 0;
+    }
+
+    bool expired() const {
+        return (useCount() == 0);
+    }
+
+    // Takes a strong reference if the object is still alive, empty pointer otherwise.
+    // Safe against a concurrent release of the last strong owner.
+    CustomSharedPtr<T, RefCount> lock() const {
+        if ((block != nullptr) && RefCount::tryIncrement(block->strong)) {
+            return CustomSharedPtr<T, RefCount>(ptr, block);
+        }
+        return CustomSharedPtr<T, RefCount>();
+    }
+
+    void release() {
+        if (block != nullptr) {
+            block->releaseWeak();
+        }
+        ptr = nullptr;
+        block = nullptr;
+    }
+};
+
+template <typename T>
+using LocalWeakPtr = CustomWeakPtr<T, NonAtomicRefCount>;
+
+}
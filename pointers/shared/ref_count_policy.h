@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+
+namespace patterns::pointers {
+
+// Reference counting policies used by the custom smart pointers.
+// A policy exposes a Counter type plus increment/decrement/load operations;
+// decrement returns true when the last reference has been dropped and
+// tryIncrement only takes a reference while the count is still non zero.
+// loadAcquire is for callers that act on a count of one, such as writing
+// to the object in place.
+
+// Plain counter for single threaded hot loops
+struct NonAtomicRefCount {
+    using Counter = long;
+
+    static void increment(Counter& count) {
+        ++count;
+    }
+
+    static bool decrement(Counter& count) {
+        return (--count == 0);
+    }
+
+    static bool tryIncrement(Counter& count) {
+        if (count == 0) {
+            return false;
+        }
+        ++count;
+        return true;
+    }
+
+    static long load(const Counter& count) {
+        return count;
+    }
+
+    static long loadAcquire(const Counter& count) {
+        return count;
+    }
+};
+
+// Thread safe counter. Increments only need atomicity, the final
+// decrement has to see every write made through the other owners.
+struct AtomicRefCount {
+    using Counter = std::atomic<long>;
+
+    static void increment(Counter& count) {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static bool decrement(Counter& count) {
+        return (count.fetch_sub(1, std::memory_order_acq_rel) == 1);
+    }
+
+    static bool tryIncrement(Counter& count) {
+        long current = count.load(std::memory_order_relaxed);
+        while (current != 0) {
+            if (count.compare_exchange_weak(current, current + 1,
+                    std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static long load(const Counter& count) {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    // Pairs with the release in decrement, so once the other owners are
+    // gone their reads and writes of the object happen before ours
+    static long loadAcquire(const Counter& count) {
+        return count.load(std::memory_order_acquire);
+    }
+};
+
+}
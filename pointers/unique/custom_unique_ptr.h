@@ -1,28 +1,98 @@
 #pragma once
 
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
 namespace patterns::pointers {
 
 template <typename T>
+struct DefaultDelete {
+    void operator()(T* ptr) const {
+        delete ptr;
+    }
+};
+
+template <typename T>
+struct DefaultDelete<T[]> {
+    void operator()(T* ptr) const {
+        delete[] ptr;
+    }
+};
+
+// Pointer plus deleter. A stateless deleter is stored as an empty base
+// so the pair stays one pointer wide.
+template <typename T, typename Deleter,
+    bool Empty = std::is_empty<Deleter>::value && !std::is_final<Deleter>::value>
+class CompressedPtr : private Deleter {
+private:
+    T* ptr;
+
+public:
+    CompressedPtr(T* ptr, Deleter deleter) : Deleter(std::move(deleter)), ptr(ptr) { }
+
+    T*& pointer() {
+        return ptr;
+    }
+
+    T* pointer() const {
+        return ptr;
+    }
+
+    Deleter& deleter() {
+        return *this;
+    }
+
+    const Deleter& deleter() const {
+        return *this;
+    }
+};
+
+template <typename T, typename Deleter>
+class CompressedPtr<T, Deleter, false> {
+private:
+    T* ptr;
+    Deleter del;
+
+public:
+    CompressedPtr(T* ptr, Deleter deleter) : ptr(ptr), del(std::move(deleter)) { }
+
+    T*& pointer() {
+        return ptr;
+    }
+
+    T* pointer() const {
+        return ptr;
+    }
+
+    Deleter& deleter() {
+        return del;
+    }
+
+    const Deleter& deleter() const {
+        return del;
+    }
+};
+
+template <typename T, typename Deleter = DefaultDelete<T>>
 class CustomUniquePtr final {
 private:
-    T* ptr = nullptr;
+    CompressedPtr<T, Deleter> data;
 
 public:
-    explicit CustomUniquePtr(T* ptr = nullptr) : ptr(ptr) {
+    explicit CustomUniquePtr(T* ptr = nullptr, Deleter deleter = Deleter()) : data(ptr, std::move(deleter)) {
     }
 
     // Movable
-    CustomUniquePtr(CustomUniquePtr&& other) noexcept : ptr(other.ptr) {
-        other.ptr = nullptr;
+    CustomUniquePtr(CustomUniquePtr&& other) noexcept : data(other.release(), std::move(other.getDeleter())) {
     }
 
     CustomUniquePtr& operator=(CustomUniquePtr&& other) noexcept {
         if (this != &other) {
-            delete this->ptr;
-            this->ptr = other.ptr;
-            other.ptr = nullptr;
+            reset(other.release());
+            getDeleter() = std::move(other.getDeleter());
         }
-        return this;
+        return *this;
     }
 
     // Not copyable
@@ -30,27 +100,107 @@ public:
     CustomUniquePtr& operator=(const CustomUniquePtr&) = delete;
 
     ~CustomUniquePtr() {
-        if (ptr != nullptr) {
-            delete ptr;
-            ptr = nullptr;
-        }
+        reset();
+    }
+
+    T* get() const {
+        return data.pointer();
+    }
+
+    Deleter& getDeleter() {
+        return data.deleter();
+    }
+
+    T* operator ->() const {
+        return get();
     }
 
-    const T* get() const {
+    T& operator *() const {
+        return *get();
+    }
+
+    operator bool() const {
+        return (get() != nullptr);
+    }
+
+    // Gives up ownership without destroying the object
+    T* release() {
+        T* ptr = data.pointer();
+        data.pointer() = nullptr;
         return ptr;
     }
 
-    const T* operator ->() const {
-        return this->ptr;
+    // Destroys the owned object, if any, and takes ownership of ptr
+    void reset(T* ptr = nullptr) {
+        T* old = data.pointer();
+        data.pointer() = ptr;
+        if (old != nullptr) {
+            data.deleter()(old);
+        }
+    }
+};
+
+// Owner of a new[] allocated buffer
+template <typename T, typename Deleter>
+class CustomUniquePtr<T[], Deleter> final {
+private:
+    CompressedPtr<T, Deleter> data;
+
+public:
+    explicit CustomUniquePtr(T* ptr = nullptr, Deleter deleter = Deleter()) : data(ptr, std::move(deleter)) {
+    }
+
+    // Movable
+    CustomUniquePtr(CustomUniquePtr&& other) noexcept : data(other.release(), std::move(other.getDeleter())) {
+    }
+
+    CustomUniquePtr& operator=(CustomUniquePtr&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+            getDeleter() = std::move(other.getDeleter());
+        }
+        return *this;
     }
 
-    const T& operator *() const {
-        return *this->ptr;
+    // Not copyable
+    CustomUniquePtr(const CustomUniquePtr&) = delete;
+    CustomUniquePtr& operator=(const CustomUniquePtr&) = delete;
+
+    ~CustomUniquePtr() {
+        reset();
     }
- 
+
+    T* get() const {
+        return data.pointer();
+    }
+
+    Deleter& getDeleter() {
+        return data.deleter();
+    }
+
+    T& operator [](std::size_t i) const {
+        return get()[i];
+    }
+
     operator bool() const {
         return (get() != nullptr);
     }
+
+    // Gives up ownership without freeing the buffer
+    T* release() {
+        T* ptr = data.pointer();
+        data.pointer() = nullptr;
+        return ptr;
+    }
+
+    // Frees the owned buffer, if any, and takes ownership of ptr
+    void reset(T* ptr = nullptr) {
+        T* old = data.pointer();
+        data.pointer() = ptr;
+        if (old != nullptr) {
+            data.deleter()(old);
+        }
+    }
 };
 
-}
\ No newline at end of file
+}
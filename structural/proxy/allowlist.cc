@@ -0,0 +1,68 @@
+#include "allowlist.h"
+
+#include <functional>
+#include <stdexcept>
+
+namespace patterns::structural {
+
+std::uint64_t Allowlist::hash(std::string_view name) {
+    return std::hash<std::string_view>()(name);
+}
+
+Allowlist::Allowlist(const std::unordered_set<std::string>& names) : _size(names.size()) {
+    // At most half full keeps probe sequences short
+    std::size_t capacity = 4;
+    while (capacity < (2 * names.size())) {
+        capacity *= 2;
+    }
+    this->_slots.assign(capacity, Slot{0, 0, emptySlot});
+    this->_mask = capacity - 1;
+
+    for (const auto& name : names) {
+        if ((name.size() >= emptySlot) || ((this->_names.size() + name.size()) > UINT32_MAX)) {
+            throw std::runtime_error("allowlist names are too long");
+        }
+        const std::uint64_t h = hash(name);
+        std::size_t i = h & this->_mask;
+        while (this->_slots[i].size != emptySlot) {
+            i = (i + 1) & this->_mask;
+        }
+        this->_slots[i] = Slot{h, static_cast<std::uint32_t>(this->_names.size()),
+            static_cast<std::uint32_t>(name.size())};
+        this->_names += name;
+    }
+}
+
+bool Allowlist::contains(std::string_view name) const {
+    const std::uint64_t h = hash(name);
+    for (std::size_t i = h & this->_mask; this->_slots[i].size != emptySlot; i = (i + 1) & this->_mask) {
+        const Slot& slot = this->_slots[i];
+        if ((slot.hash == h) && (std::string_view(this->_names).substr(slot.offset, slot.size) == name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t Allowlist::size() const {
+    return this->_size;
+}
+
+ReloadableAllowlist::ReloadableAllowlist(const std::unordered_set<std::string>& names)
+    : _current(pointers::makeCustomShared<Allowlist>(names)), _generation(0) { }
+
+void ReloadableAllowlist::reload(const std::unordered_set<std::string>& names) {
+    this->_current.store(pointers::makeCustomShared<Allowlist>(names));
+    // Bumped after the store, so whoever sees the new generation also sees the new list
+    this->_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+std::uint64_t ReloadableAllowlist::generation() const {
+    return this->_generation.load(std::memory_order_acquire);
+}
+
+bool ReloadableAllowlist::allows(std::string_view name) const {
+    return this->_current.load()->contains(name);
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "../../pointers/shared/atomic_custom_shared_ptr.h"
+#include "../../pointers/shared/custom_shared_ptr.h"
+
+namespace patterns::structural {
+
+// Immutable set of names in one open addressing table. All names share a
+// single buffer and each slot keeps the full hash, so a lookup hashes the
+// name once and only compares strings whose hash matches.
+class Allowlist final {
+private:
+    struct Slot {
+        std::uint64_t hash;
+        std::uint32_t offset;
+        // emptySlot marks an unused slot
+        std::uint32_t size;
+    };
+
+    static constexpr std::uint32_t emptySlot = UINT32_MAX;
+
+    std::string _names;
+    std::vector<Slot> _slots;
+    std::size_t _mask = 0;
+    std::size_t _size = 0;
+
+    static std::uint64_t hash(std::string_view name);
+
+public:
+    explicit Allowlist(const std::unordered_set<std::string>& names);
+
+    bool contains(std::string_view name) const;
+    std::size_t size() const;
+};
+
+// Allowlist that can be replaced while requests are running. Readers never
+// block: they load the current snapshot without a lock and keep it alive for
+// as long as they use it. generation() changes on every reload, so callers
+// can cache decisions and only redo them after a reload.
+class ReloadableAllowlist final {
+private:
+    pointers::AtomicCustomSharedPtr<Allowlist> _current;
+    std::atomic<std::uint64_t> _generation;
+
+public:
+    explicit ReloadableAllowlist(const std::unordered_set<std::string>& names);
+
+    ReloadableAllowlist(const ReloadableAllowlist&) = delete;
+    ReloadableAllowlist& operator=(const ReloadableAllowlist&) = delete;
+
+    void reload(const std::unordered_set<std::string>& names);
+    std::uint64_t generation() const;
+    bool allows(std::string_view name) const;
+};
+
+using SharedAllowlist = pointers::CustomSharedPtr<ReloadableAllowlist>;
+
+}
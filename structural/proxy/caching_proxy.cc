@@ -0,0 +1,91 @@
+#include "caching_proxy.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace patterns::structural {
+
+CachingProxy::CachingProxy(std::string name, UniqueService service, std::size_t capacity,
+    Clock::duration ttl, std::size_t shards)
+    : Service(std::move(name)), _service(std::move(service)), _ttl(ttl),
+      _shardCount(std::max<std::size_t>(1, std::min(shards, capacity))), _shards(new Shard[_shardCount]) {
+    if (!this->_service || (capacity == 0)) {
+        throw std::runtime_error("caching proxy needs a service and a non zero capacity");
+    }
+    // The first capacity % shards shards take one extra entry
+    for (std::size_t i = 0; i < this->_shardCount; ++i) {
+        this->_shards[i].capacity = capacity / this->_shardCount + ((i < capacity % this->_shardCount) ? 1 : 0);
+    }
+}
+
+CachingProxy::Shard& CachingProxy::shard(const std::string& query) const {
+    return this->_shards[std::hash<std::string>()(query) % this->_shardCount];
+}
+
+std::string CachingProxy::request() const {
+    return this->request(std::string());
+}
+
+std::string CachingProxy::request(const std::string& query) const {
+    Shard& shard = this->shard(query);
+    {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        const auto found = shard.index.find(query);
+        if (found != shard.index.end()) {
+            const auto entry = found->second;
+            if (entry->expires > Clock::now()) {
+                ++shard.stats.hits;
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+                return entry->response;
+            }
+            shard.index.erase(found);
+            shard.lru.erase(entry);
+        }
+        ++shard.stats.misses;
+    }
+
+    std::string response = this->_service->request(query);
+    const auto expires = Clock::now() + this->_ttl;
+
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    // Another caller may have filled the same query meanwhile
+    const auto found = shard.index.find(query);
+    if (found != shard.index.end()) {
+        found->second->response = response;
+        found->second->expires = expires;
+        shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+        return response;
+    }
+
+    shard.lru.push_front(Entry{query, response, expires});
+    shard.index.emplace(shard.lru.front().query, shard.lru.begin());
+    if (shard.lru.size() > shard.capacity) {
+        shard.index.erase(shard.lru.back().query);
+        shard.lru.pop_back();
+        ++shard.stats.evictions;
+    }
+    return response;
+}
+
+CachingProxy::Stats CachingProxy::stats() const {
+    Stats total;
+    for (std::size_t i = 0; i < this->_shardCount; ++i) {
+        std::lock_guard<std::mutex> lock(this->_shards[i].mtx);
+        total.hits += this->_shards[i].stats.hits;
+        total.misses += this->_shards[i].stats.misses;
+        total.evictions += this->_shards[i].stats.evictions;
+    }
+    return total;
+}
+
+std::size_t CachingProxy::size() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < this->_shardCount; ++i) {
+        std::lock_guard<std::mutex> lock(this->_shards[i].mtx);
+        total += this->_shards[i].lru.size();
+    }
+    return total;
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "proxy.h"
+
+namespace patterns::structural {
+
+// Memoizes the wrapped service. Keeps at most capacity results, drops the
+// least recently used one when full and recomputes results older than ttl.
+// Keys are spread over independently locked shards, each its own LRU, and
+// the wrapped service is called outside of any lock. Shard capacities add up
+// to exactly capacity, there are never more shards than capacity.
+class CachingProxy : public Service {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        // Includes lookups that found an expired result
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+    };
+
+private:
+    struct Entry {
+        std::string query;
+        std::string response;
+        Clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        // Most recently used first
+        std::list<Entry> lru;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+        std::size_t capacity = 0;
+        Stats stats;
+    };
+
+    UniqueService _service;
+    Clock::duration _ttl;
+    std::size_t _shardCount;
+    std::unique_ptr<Shard[]> _shards;
+
+    Shard& shard(const std::string& query) const;
+
+public:
+    CachingProxy(std::string name, UniqueService service, std::size_t capacity, Clock::duration ttl,
+        std::size_t shards = 16);
+    ~CachingProxy() override = default;
+
+    std::string request() const override;
+    std::string request(const std::string& query) const override;
+    Stats stats() const;
+    // Results currently cached, expired ones included until looked up again
+    std::size_t size() const;
+};
+
+}
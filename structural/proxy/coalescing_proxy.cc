@@ -0,0 +1,60 @@
+#include "coalescing_proxy.h"
+
+#include <exception>
+#include <stdexcept>
+
+namespace patterns::structural {
+
+CoalescingProxy::CoalescingProxy(std::string name, UniqueService service)
+    : Service(std::move(name)), _service(std::move(service)), _calls(0), _coalesced(0) {
+    if (!this->_service) {
+        throw std::runtime_error("coalescing proxy needs a service");
+    }
+}
+
+std::string CoalescingProxy::request() const {
+    return this->request(std::string());
+}
+
+std::string CoalescingProxy::request(const std::string& query) const {
+    std::promise<std::string> promise;
+    {
+        std::unique_lock<std::mutex> lock(this->_mtx);
+        const auto found = this->_inFlight.find(query);
+        if (found != this->_inFlight.end()) {
+            auto response = found->second;
+            lock.unlock();
+            ++this->_coalesced;
+            return response.get();
+        }
+        this->_inFlight.emplace(query, promise.get_future().share());
+    }
+
+    // This caller leads the flight. Removing it before publishing the result
+    // means later callers start a fresh call instead of reading an old one.
+    ++this->_calls;
+    std::string response;
+    std::exception_ptr error;
+    try {
+        response = this->_service->request(query);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->_mtx);
+        this->_inFlight.erase(query);
+    }
+
+    if (error) {
+        promise.set_exception(error);
+        std::rethrow_exception(error);
+    }
+    promise.set_value(response);
+    return response;
+}
+
+CoalescingProxy::Stats CoalescingProxy::stats() const {
+    return Stats{this->_calls.load(), this->_coalesced.load()};
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "proxy.h"
+
+namespace patterns::structural {
+
+// Collapses concurrent identical requests into one call of the wrapped
+// service. The first caller for a query does the call, callers arriving
+// while it runs wait for its response, or its exception, instead of
+// calling the service themselves. Nothing is kept once the call returns.
+class CoalescingProxy : public Service {
+public:
+    struct Stats {
+        std::uint64_t calls = 0;
+        // Requests answered by a call another caller made
+        std::uint64_t coalesced = 0;
+    };
+
+private:
+    UniqueService _service;
+    mutable std::mutex _mtx;
+    mutable std::unordered_map<std::string, std::shared_future<std::string>> _inFlight;
+    mutable std::atomic<std::uint64_t> _calls;
+    mutable std::atomic<std::uint64_t> _coalesced;
+
+public:
+    CoalescingProxy(std::string name, UniqueService service);
+    ~CoalescingProxy() override = default;
+
+    std::string request() const override;
+    std::string request(const std::string& query) const override;
+    Stats stats() const;
+};
+
+}
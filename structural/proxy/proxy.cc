@@ -4,26 +4,119 @@ namespace patterns::structural {
  
 Service::Service(std::string name) : _name(std::move(name)) { }
 
+std::string Service::request(const std::string&) const {
+    return this->request();
+}
+
+concurrency::Task<std::string> Service::asyncRequest(std::string query, concurrency::Executor& executor) const {
+    co_await executor.schedule();
+    co_return this->request(query);
+}
+
 ServiceA::ServiceA(std::string name) : Service(std::move(name)) { }
 
 std::string ServiceA::request() const {
     return this->_name;
 }
 
-bool Proxy::allow(const std::string& name) const {
-    return (this->_allowed.find(name) != this->_allowed.end());
+std::string ServiceA::request(const std::string& query) const {
+    if (query.empty()) {
+        return this->request();
+    }
+    return this->_name + "/" + query;
+}
+
+concurrency::Task<std::string> ServiceA::asyncRequest(std::string query, concurrency::Executor&) const {
+    co_return this->request(query);
+}
+
+bool Proxy::allowed() const {
+    const std::uint64_t generation = this->_allowlist->generation();
+    const std::uint64_t decision = this->_decision.load(std::memory_order_relaxed);
+    if ((decision != noDecision) && ((decision >> 1) == generation)) {
+        return (decision & 1) != 0;
+    }
+
+    const bool allow = this->_allowlist->allows(this->_name);
+    this->_decision.store((generation << 1) | (allow ? 1 : 0), std::memory_order_relaxed);
+    return allow;
 }
 
 Proxy::Proxy(std::string name, std::unordered_set<std::string> allowedNames) 
-    : Service(name), _allowed(std::move(allowedNames)) {
-    this->_serviceA = std::make_unique<ServiceA>(name);
+    : Proxy(std::move(name), pointers::makeCustomShared<ReloadableAllowlist>(allowedNames)) {
+}
+
+ServiceA& Proxy::service() const {
+    ServiceA* service = this->_service.load(std::memory_order_acquire);
+    if (service != nullptr) {
+        return *service;
+    }
+
+    std::lock_guard<std::mutex> lock(this->_serviceMtx);
+    service = this->_service.load(std::memory_order_relaxed);
+    if (service == nullptr) {
+        // A throwing factory leaves the proxy unbuilt, the next request tries again
+        this->_serviceA = this->_factory(this->_name);
+        service = this->_serviceA.get();
+        this->_service.store(service, std::memory_order_release);
+    }
+    return *service;
+}
+
+Proxy::Proxy(std::string name, SharedAllowlist allowlist, Construction construction, ServiceAFactory factory)
+    : Service(std::move(name)), _allowlist(std::move(allowlist)), _decision(noDecision),
+      _factory(std::move(factory)), _service(nullptr) {
+    if (!this->_factory) {
+        this->_factory = [](const std::string& name) {
+            return std::make_unique<ServiceA>(name);
+        };
+    }
+    if (construction == Construction::Eager) {
+        this->service();
+    }
 }
 
 std::string Proxy::request() const {
-    if (!this->allow(this->_name)) {
+    if (!this->allowed()) {
         return {};
     }
-    return this->_serviceA->request();
+    return this->service().request();
+}
+
+std::string Proxy::request(const std::string& query) const {
+    if (!this->allowed()) {
+        return {};
+    }
+    return this->service().request(query);
+}
+
+concurrency::Task<std::string> Proxy::asyncRequest(std::string query, concurrency::Executor& executor) const {
+    if (!this->allowed()) {
+        co_return std::string();
+    }
+    co_return co_await this->service().asyncRequest(std::move(query), executor);
 }
 
-}
\ No newline at end of file
+const SharedAllowlist& Proxy::allowlist() const {
+    return this->_allowlist;
+}
+
+bool Proxy::constructed() const {
+    return this->_service.load(std::memory_order_acquire) != nullptr;
+}
+
+void Proxy::prewarm(concurrency::ThreadPool& pool) const {
+    if (this->constructed()) {
+        return;
+    }
+    pool.submit([this]() {
+        // Pool tasks must not throw. A failed prewarm leaves the proxy unbuilt
+        // and the first request tries again.
+        try {
+            this->service();
+        } catch (...) {
+        }
+    });
+}
+
+}
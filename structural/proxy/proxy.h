@@ -1,9 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <unordered_set>
 
+#include "../../concurrency/executor.h"
+#include "../../concurrency/task.h"
+#include "../../concurrency/thread_pool.h"
+#include "allowlist.h"
+
 namespace patterns::structural {
 
 class Service {
@@ -14,27 +23,69 @@ protected:
 public:
     virtual ~Service() = default;
     virtual std::string request() const = 0;
+    // Request for one resource of the service, the plain request() by default
+    virtual std::string request(const std::string& query) const;
+    // Coroutine counterpart of request(query). By default it runs the blocking
+    // request on the executor, so at least the caller does not wait on it.
+    // The service has to outlive the task.
+    virtual concurrency::Task<std::string> asyncRequest(std::string query, concurrency::Executor& executor) const;
 };
 
+using UniqueService = std::unique_ptr<Service>;
+
 class ServiceA : public Service {
 public:
     ServiceA(std::string name);
     ~ServiceA() override = default;
     std::string request() const override;
+    // "<name>/<query>", an empty query is the plain request()
+    std::string request(const std::string& query) const override;
+    // Answers right away, there is nothing to wait for
+    concurrency::Task<std::string> asyncRequest(std::string query, concurrency::Executor& executor) const override;
 };
 
 using UniqueServiceA = std::unique_ptr<ServiceA>;
+using ServiceAFactory = std::function<UniqueServiceA(const std::string& name)>;
+
+// When Proxy builds the ServiceA behind it
+enum class Construction : int {
+    // In the constructor
+    Eager,
+    // On the first allowed request, so denied or idle proxies never pay for it
+    Lazy
+};
 
 class Proxy : public Service {
 private:
-    std::unordered_set<std::string> _allowed;
-    UniqueServiceA _serviceA;
+    // The name never changes, so the allowlist decision for it is cached as
+    // (generation << 1) | allowed and redone only after a reload
+    static constexpr std::uint64_t noDecision = UINT64_MAX;
+
+    SharedAllowlist _allowlist;
+    mutable std::atomic<std::uint64_t> _decision;
+    ServiceAFactory _factory;
+    // Built at most once, after that service() is a single acquire load
+    mutable std::mutex _serviceMtx;
+    mutable UniqueServiceA _serviceA;
+    mutable std::atomic<ServiceA*> _service;
     
-    bool allow(const std::string& name) const;
+    bool allowed() const;
+    ServiceA& service() const;
 public:
     Proxy(std::string name, std::unordered_set<std::string> allowedNames);
+    // Shares the allowlist, a reload through it reaches every proxy using it.
+    // The factory defaults to constructing a plain ServiceA.
+    Proxy(std::string name, SharedAllowlist allowlist, Construction construction = Construction::Eager,
+        ServiceAFactory factory = nullptr);
     ~Proxy() override = default;
     std::string request() const override;
+    std::string request(const std::string& query) const override;
+    concurrency::Task<std::string> asyncRequest(std::string query, concurrency::Executor& executor) const override;
+    const SharedAllowlist& allowlist() const;
+    bool constructed() const;
+    // Builds a lazy service on the pool ahead of the first request.
+    // The proxy has to outlive the task.
+    void prewarm(concurrency::ThreadPool& pool) const;
 };
 
 }
\ No newline at end of file
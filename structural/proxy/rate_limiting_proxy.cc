@@ -0,0 +1,120 @@
+#include "rate_limiting_proxy.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace patterns::structural {
+
+std::int64_t TokenBucket::ticks(Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+namespace {
+
+// Keeps an interval or a window added to a clock reading well in range,
+// a span of about 73 years
+constexpr std::int64_t maxSpan = INT64_MAX / 4;
+
+}
+
+std::int64_t TokenBucket::intervalOf(double tokensPerSecond) {
+    // Also rejects NaN
+    if (!(tokensPerSecond > 0)) {
+        throw std::runtime_error("token bucket needs a positive rate");
+    }
+    const double interval = 1e9 / tokensPerSecond;
+    if ((interval < 1) || (interval > static_cast<double>(maxSpan))) {
+        throw std::runtime_error("token bucket rate out of range");
+    }
+    return static_cast<std::int64_t>(interval);
+}
+
+std::int64_t TokenBucket::windowOf(std::int64_t interval, std::size_t burst) {
+    if (burst == 0) {
+        throw std::runtime_error("token bucket needs a positive burst");
+    }
+    if (burst > static_cast<std::uint64_t>(maxSpan / interval)) {
+        throw std::runtime_error("token bucket burst out of range");
+    }
+    return interval * static_cast<std::int64_t>(burst);
+}
+
+TokenBucket::TokenBucket(double tokensPerSecond, std::size_t burst)
+    : _interval(intervalOf(tokensPerSecond)), _window(windowOf(_interval, burst)), _full(0) { }
+
+bool TokenBucket::tryTake(Clock::time_point now) {
+    const std::int64_t at = ticks(now);
+    std::int64_t full = this->_full.load(std::memory_order_relaxed);
+    while (true) {
+        // A bucket full in the past is simply full
+        const std::int64_t next = std::max(full, at) + this->_interval;
+        if ((next - at) > this->_window) {
+            return false;
+        }
+        if (this->_full.compare_exchange_weak(full, next, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+TokenBucket::Clock::time_point TokenBucket::take(Clock::time_point now) {
+    const std::int64_t at = ticks(now);
+    std::int64_t full = this->_full.load(std::memory_order_relaxed);
+    std::int64_t next = 0;
+    do {
+        next = std::max(full, at) + this->_interval;
+    } while (!this->_full.compare_exchange_weak(full, next, std::memory_order_relaxed));
+    return now + std::chrono::nanoseconds(std::max<std::int64_t>(0, next - at - this->_window));
+}
+
+RateLimiter::RateLimiter(double tokensPerSecond, std::size_t burst)
+    : _tokensPerSecond(tokensPerSecond), _burst(burst) {
+    TokenBucket::windowOf(TokenBucket::intervalOf(tokensPerSecond), burst);
+}
+
+TokenBucket& RateLimiter::bucket(const std::string& caller) {
+    std::lock_guard<std::mutex> lock(this->_mtx);
+    auto& bucket = this->_buckets[caller];
+    if (!bucket) {
+        bucket = std::make_unique<TokenBucket>(this->_tokensPerSecond, this->_burst);
+    }
+    return *bucket;
+}
+
+TokenBucket& RateLimitingProxy::bucketOf(const SharedRateLimiter& limiter, const std::string& caller) {
+    if (!limiter) {
+        throw std::runtime_error("rate limiting proxy needs a limiter");
+    }
+    return limiter->bucket(caller);
+}
+
+RateLimitingProxy::RateLimitingProxy(std::string name, UniqueService service, SharedRateLimiter limiter,
+    OverLimit overLimit)
+    : Service(std::move(name)), _service(std::move(service)), _limiter(std::move(limiter)),
+      _bucket(bucketOf(_limiter, _name)), _overLimit(overLimit) {
+    if (!this->_service) {
+        throw std::runtime_error("rate limiting proxy needs a service");
+    }
+}
+
+bool RateLimitingProxy::admit() const {
+    if (this->_overLimit == OverLimit::Reject) {
+        return this->_bucket.tryTake();
+    }
+    std::this_thread::sleep_until(this->_bucket.take());
+    return true;
+}
+
+std::string RateLimitingProxy::request() const {
+    return this->request(std::string());
+}
+
+std::string RateLimitingProxy::request(const std::string& query) const {
+    if (!this->admit()) {
+        return {};
+    }
+    return this->_service->request(query);
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "../../pointers/shared/custom_shared_ptr.h"
+#include "proxy.h"
+
+namespace patterns::structural {
+
+// Token bucket in a single atomic word. Instead of a token count and a
+// refill time it stores the time at which the bucket will be full again:
+// every token taken pushes that time one interval further, and the bucket
+// is empty once it lies more than burst intervals ahead of now. Refill and
+// take are then one compare and swap, without a lock.
+class alignas(64) TokenBucket final {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    // Checks its rate and burst up front, before any bucket is made
+    friend class RateLimiter;
+
+    std::int64_t _interval;
+    std::int64_t _window;
+    // Nanoseconds of Clock
+    std::atomic<std::int64_t> _full;
+
+    static std::int64_t ticks(Clock::time_point time);
+    // Checked before any arithmetic, throw when out of range
+    static std::int64_t intervalOf(double tokensPerSecond);
+    static std::int64_t windowOf(std::int64_t interval, std::size_t burst);
+
+public:
+    TokenBucket(double tokensPerSecond, std::size_t burst);
+
+    // Takes a token when one is left
+    bool tryTake(Clock::time_point now = Clock::now());
+    // Takes a token even when empty, returns the time at which it becomes
+    // valid. Callers waiting until then are served in the order they came.
+    Clock::time_point take(Clock::time_point now = Clock::now());
+};
+
+// Token buckets by caller name, all with the same rate and burst.
+// Buckets are created on first use and live as long as the limiter.
+// The rate and burst are checked at construction, like TokenBucket does.
+class RateLimiter final {
+private:
+    double _tokensPerSecond;
+    std::size_t _burst;
+    std::mutex _mtx;
+    std::unordered_map<std::string, std::unique_ptr<TokenBucket>> _buckets;
+
+public:
+    RateLimiter(double tokensPerSecond, std::size_t burst);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    TokenBucket& bucket(const std::string& caller);
+};
+
+using SharedRateLimiter = pointers::CustomSharedPtr<RateLimiter>;
+
+// What a RateLimitingProxy does with a request over the limit
+enum class OverLimit : int {
+    // Answers with an empty response, like Proxy for a caller it does not allow
+    Reject,
+    // Waits until a token is available
+    Wait
+};
+
+// Limits the rate at which the caller, named by the proxy name, reaches the
+// wrapped service. The bucket is looked up once at construction, so the
+// request path is one compare and swap on it. Proxies with the same name
+// on the same limiter share a bucket.
+class RateLimitingProxy : public Service {
+private:
+    UniqueService _service;
+    SharedRateLimiter _limiter;
+    TokenBucket& _bucket;
+    OverLimit _overLimit;
+
+    static TokenBucket& bucketOf(const SharedRateLimiter& limiter, const std::string& caller);
+    bool admit() const;
+
+public:
+    RateLimitingProxy(std::string name, UniqueService service, SharedRateLimiter limiter,
+        OverLimit overLimit = OverLimit::Reject);
+    ~RateLimitingProxy() override = default;
+
+    std::string request() const override;
+    std::string request(const std::string& query) const override;
+};
+
+}